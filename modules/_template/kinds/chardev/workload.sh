@@ -0,0 +1,48 @@
+#!/bin/bash
+# ==============================================================================
+# template workload for scripts/test-module.sh
+# ==============================================================================
+# Times TEMPLATE_ITERS writes to /dev/$MODULE, drains the rings and checks
+# every write was seen and recorded or counted as dropped.
+#
+# Environment: MODULE, RESULTS_DIR, TEMPLATE_ITERS (default 1000)
+# ==============================================================================
+
+set -e
+
+ITERS="${TEMPLATE_ITERS:-1000}"
+DEV="/dev/$MODULE"
+DEBUG_DIR="/sys/kernel/debug/$MODULE"
+mkdir -p "$RESULTS_DIR"
+mount -t debugfs none /sys/kernel/debug 2>/dev/null || true
+
+total() {
+    awk -v col="$1" '$1 == "total" { print $col }' "$DEBUG_DIR/stats"
+}
+
+# Start from empty rings
+cat "$DEV" > /dev/null
+
+start=$(date +%s%N)
+for (( i = 0; i < ITERS; i++ )); do
+    echo "event $i" > "$DEV"
+done
+end=$(date +%s%N)
+
+cat "$DEV" > "$RESULTS_DIR/events.bin"
+cat "$DEBUG_DIR/stats" > "$RESULTS_DIR/stats.txt"
+
+writes=$(total 2)
+events=$(total 4)
+dropped=$(total 5)
+
+{
+    echo "iters=$ITERS"
+    echo "ns_per_write=$(( (end - start) / ITERS ))"
+    echo "writes=$writes"
+    echo "events=$events"
+    echo "dropped=$dropped"
+    echo "event_bytes=$(stat -c %s "$RESULTS_DIR/events.bin")"
+} | tee "$RESULTS_DIR/bench.txt"
+
+[ "$writes" -ge "$ITERS" ] && [ $(( events + dropped )) -eq "$writes" ]
@@ -0,0 +1,278 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * template.c - Per-CPU Latency Statistics
+ *
+ * Times every call of one kernel function (target_func, default
+ * do_sys_openat2) with a kretprobe and keeps per-CPU call counts and a
+ * log2 latency histogram. Calls slower than slow_ns are also recorded in
+ * a per-CPU event ring.
+ *
+ * Hot path:
+ *   - Entry stores a timestamp in a kretprobe instance, from a pool of
+ *     maxactive instances shared by all CPUs and preallocated at register
+ *     time. Calls beyond that many in flight at once are not timed and
+ *     show up as "missed".
+ *   - Return does two per-CPU increments. Only slow calls touch the
+ *     ring, preallocated at load time (lab_ring.h). No allocation, no
+ *     shared lock.
+ *
+ * Interface:
+ *   /sys/kernel/debug/template/stats       per-CPU calls/slow/dropped,
+ *                                          plus kretprobe misses
+ *   /sys/kernel/debug/template/histogram   latency buckets, all CPUs
+ *   /sys/kernel/debug/template/events      read() returns whole struct
+ *                                          template_event records (slow
+ *                                          calls), draining every CPU's
+ *                                          ring; 0 when empty
+ *
+ * Usage:
+ *   insmod template.ko [target_func=vfs_read] [slow_ns=50000]
+ *   cat /sys/kernel/debug/template/histogram
+ *   rmmod template
+ *
+ * Benchmark: make test MODULE=template (runs workload.sh)
+ *
+ * Requires: CONFIG_KPROBES=y CONFIG_KRETPROBES=y
+ */
+
+#include <linux/debugfs.h>
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/kprobes.h>
+#include <linux/log2.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/percpu.h>
+#include <linux/sched.h>
+#include <linux/sched/clock.h>
+#include <linux/seq_file.h>
+#include <linux/string.h>
+
+#include "lab_ring.h"
+
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("Your Name");
+MODULE_DESCRIPTION("kretprobe-based per-CPU latency statistics");
+MODULE_VERSION("1.0");
+
+static char *target_func = "do_sys_openat2";
+module_param(target_func, charp, 0444);
+MODULE_PARM_DESC(target_func, "Kernel function to time (default: do_sys_openat2)");
+
+static unsigned long slow_ns = 100000;
+module_param(slow_ns, ulong, 0644);
+MODULE_PARM_DESC(slow_ns, "Record calls slower than this in the event ring (default: 100000)");
+
+/* Events per CPU ring, must be a power of two */
+#define TEMPLATE_RING_SIZE 1024
+
+/* Bucket i counts calls taking [2^i, 2^(i+1)) ns; the last is open-ended */
+#define TEMPLATE_HIST_BUCKETS 32
+
+/* One record per slow call */
+struct template_event {
+	u64 ts_ns;		/* return time */
+	u64 delta_ns;
+	u32 pid;
+	u32 cpu;
+	char comm[TASK_COMM_LEN];
+};
+
+/* One ring per CPU: template_bufs and its helpers, see lab_ring.h */
+LAB_RING_DEFINE(template, struct template_event, TEMPLATE_RING_SIZE);
+
+struct template_stats {
+	u64 calls;	/* target_func returns seen */
+	u64 events;	/* slow calls recorded */
+	u64 dropped;	/* slow calls lost to a full ring */
+	u64 hist[TEMPLATE_HIST_BUCKETS];
+};
+
+/* kretprobe per-instance data */
+struct template_call {
+	u64 start_ns;
+};
+
+static DEFINE_PER_CPU(struct template_stats, template_stats);
+
+/* Serialises readers, the only writers of each ring's tail */
+static DEFINE_MUTEX(template_read_lock);
+
+static struct dentry *debug_dir;
+
+/* ═══════════════════════════════════════════════════════════════════
+ *                             HOOK
+ * ═══════════════════════════════════════════════════════════════════ */
+
+static int template_entry(struct kretprobe_instance *ri, struct pt_regs *regs)
+{
+	struct template_call *call = (struct template_call *)ri->data;
+
+	call->start_ns = local_clock();
+	return 0;
+}
+
+static void template_record(u64 now, u64 delta)
+{
+	struct template_event *ev;
+	unsigned long flags;
+
+	/* An interrupt on this CPU may return from target_func too */
+	local_irq_save(flags);
+
+	ev = template_reserve();
+	if (!ev) {
+		this_cpu_inc(template_stats.dropped);
+		goto out;
+	}
+
+	ev->ts_ns = now;
+	ev->delta_ns = delta;
+	ev->pid = current->pid;
+	ev->cpu = smp_processor_id();
+	memcpy(ev->comm, current->comm, TASK_COMM_LEN);
+
+	template_commit();
+	this_cpu_inc(template_stats.events);
+out:
+	local_irq_restore(flags);
+}
+
+static int template_ret(struct kretprobe_instance *ri, struct pt_regs *regs)
+{
+	struct template_call *call = (struct template_call *)ri->data;
+	u64 now = local_clock();
+	u64 delta = now - call->start_ns;
+	unsigned int bucket = 0;
+
+	/*
+	 * local_clock() is only monotonic per CPU: a task that migrated
+	 * between entry and return can see a slightly earlier "now".
+	 */
+	if ((s64)delta < 0)
+		delta = 0;
+
+	if (delta)
+		bucket = min_t(unsigned int, ilog2(delta),
+			       TEMPLATE_HIST_BUCKETS - 1);
+
+	this_cpu_inc(template_stats.calls);
+	this_cpu_inc(template_stats.hist[bucket]);
+
+	if (unlikely(delta >= READ_ONCE(slow_ns)))
+		template_record(now, delta);
+	return 0;
+}
+
+static struct kretprobe template_krp = {
+	.handler       = template_ret,
+	.entry_handler = template_entry,
+	.data_size     = sizeof(struct template_call),
+	.maxactive     = 64,	/* calls in flight at once, all CPUs */
+};
+
+/* ═══════════════════════════════════════════════════════════════════
+ *                          READER SIDE
+ * ═══════════════════════════════════════════════════════════════════ */
+
+static ssize_t events_read(struct file *file, char __user *buf,
+			   size_t count, loff_t *ppos)
+{
+	ssize_t ret;
+
+	if (count < sizeof(struct template_event))
+		return -EINVAL;
+
+	mutex_lock(&template_read_lock);
+	ret = template_drain(buf, count);
+	mutex_unlock(&template_read_lock);
+
+	return ret;
+}
+
+static const struct file_operations events_fops = {
+	.owner  = THIS_MODULE,
+	.read   = events_read,
+	.llseek = noop_llseek,
+};
+
+/* ═══════════════════════════════════════════════════════════════════
+ *                         DEBUGFS STATS
+ * ═══════════════════════════════════════════════════════════════════ */
+
+static int stats_show(struct seq_file *m, void *v)
+{
+	static const char *const cols[] = { "calls", "slow", "dropped" };
+
+	lab_ring_show_stats(m, &template_stats, cols, ARRAY_SIZE(cols));
+	seq_printf(m, "missed %d\n", template_krp.nmissed);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(stats);
+
+static int histogram_show(struct seq_file *m, void *v)
+{
+	int i, cpu;
+
+	seq_printf(m, "%14s %12s\n", ">= ns", "calls");
+	for (i = 0; i < TEMPLATE_HIST_BUCKETS; i++) {
+		u64 n = 0;
+
+		for_each_possible_cpu(cpu)
+			n += per_cpu_ptr(&template_stats, cpu)->hist[i];
+		if (n)
+			seq_printf(m, "%14llu %12llu\n", i ? 1ULL << i : 0ULL, n);
+	}
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(histogram);
+
+/* ═══════════════════════════════════════════════════════════════════
+ *                       MODULE INIT / EXIT
+ * ═══════════════════════════════════════════════════════════════════ */
+
+static int __init template_init(void)
+{
+	int ret;
+
+	ret = template_alloc_bufs();
+	if (ret) {
+		pr_err("template: failed to allocate per-CPU rings\n");
+		return ret;
+	}
+
+	debug_dir = debugfs_create_dir("template", NULL);
+	debugfs_create_file("stats", 0444, debug_dir, NULL, &stats_fops);
+	debugfs_create_file("histogram", 0444, debug_dir, NULL,
+			    &histogram_fops);
+	debugfs_create_file("events", 0400, debug_dir, NULL, &events_fops);
+
+	template_krp.kp.symbol_name = target_func;
+	ret = register_kretprobe(&template_krp);
+	if (ret < 0) {
+		pr_err("template: cannot probe '%s': %d\n", target_func, ret);
+		goto fail_probe;
+	}
+
+	pr_info("template: timing %s at %px (slow_ns=%lu)\n", target_func,
+		template_krp.kp.addr, slow_ns);
+	return 0;
+
+fail_probe:
+	debugfs_remove_recursive(debug_dir);
+	template_free_bufs();
+	return ret;
+}
+
+static void __exit template_exit(void)
+{
+	/* Waits for handlers in flight before the rings go away */
+	unregister_kretprobe(&template_krp);
+
+	debugfs_remove_recursive(debug_dir);
+	template_free_bufs();
+	pr_info("template: unloaded (%d missed)\n", template_krp.nmissed);
+}
+
+module_init(template_init);
+module_exit(template_exit);
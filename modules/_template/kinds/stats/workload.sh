@@ -0,0 +1,47 @@
+#!/bin/bash
+# ==============================================================================
+# template workload for scripts/test-module.sh
+# ==============================================================================
+# Times TEMPLATE_ITERS opens of /etc/hostname (the default target_func is
+# do_sys_openat2), saves the latency histogram and checks every call was
+# counted. Edit the loop if you change target_func.
+#
+# Environment: MODULE, RESULTS_DIR, TEMPLATE_ITERS (default 5000)
+# ==============================================================================
+
+set -e
+
+ITERS="${TEMPLATE_ITERS:-5000}"
+DEBUG_DIR="/sys/kernel/debug/$MODULE"
+mkdir -p "$RESULTS_DIR"
+mount -t debugfs none /sys/kernel/debug 2>/dev/null || true
+
+total() {
+    awk -v col="$1" '$1 == "total" { print $col }' "$DEBUG_DIR/stats"
+}
+
+cat "$DEBUG_DIR/events" > /dev/null
+calls_before=$(total 2)
+
+start=$(date +%s%N)
+for (( i = 0; i < ITERS; i++ )); do
+    : < /etc/hostname
+done
+end=$(date +%s%N)
+
+calls=$(( $(total 2) - calls_before ))
+cat "$DEBUG_DIR/histogram" > "$RESULTS_DIR/histogram.txt"
+cat "$DEBUG_DIR/stats" > "$RESULTS_DIR/stats.txt"
+cat "$DEBUG_DIR/events" > "$RESULTS_DIR/events.bin"
+
+{
+    echo "iters=$ITERS"
+    echo "ns_per_op=$(( (end - start) / ITERS ))"
+    echo "calls=$calls"
+    echo "slow=$(total 3)"
+    awk '$1 == "missed" { print "missed=" $2 }' "$DEBUG_DIR/stats"
+} | tee "$RESULTS_DIR/bench.txt"
+
+cat "$RESULTS_DIR/histogram.txt"
+
+[ "$calls" -ge "$ITERS" ]
@@ -0,0 +1,45 @@
+#!/bin/bash
+# ==============================================================================
+# template workload for scripts/test-module.sh
+# ==============================================================================
+# Times TEMPLATE_ITERS opens of /etc/hostname (the default target_func is
+# do_sys_openat2), drains the event rings and checks the hook saw every
+# call. Edit the loop if you change target_func.
+#
+# Environment: MODULE, RESULTS_DIR, TEMPLATE_ITERS (default 5000)
+# ==============================================================================
+
+set -e
+
+ITERS="${TEMPLATE_ITERS:-5000}"
+DEBUG_DIR="/sys/kernel/debug/$MODULE"
+mkdir -p "$RESULTS_DIR"
+mount -t debugfs none /sys/kernel/debug 2>/dev/null || true
+
+total() {
+    awk -v col="$1" '$1 == "total" { print $col }' "$DEBUG_DIR/stats"
+}
+
+# Start from empty rings
+cat "$DEBUG_DIR/events" > /dev/null
+calls_before=$(total 2)
+
+start=$(date +%s%N)
+for (( i = 0; i < ITERS; i++ )); do
+    : < /etc/hostname
+done
+end=$(date +%s%N)
+
+calls=$(( $(total 2) - calls_before ))
+cat "$DEBUG_DIR/events" > "$RESULTS_DIR/events.bin"
+cat "$DEBUG_DIR/stats" > "$RESULTS_DIR/stats.txt"
+
+{
+    echo "iters=$ITERS"
+    echo "ns_per_op=$(( (end - start) / ITERS ))"
+    echo "calls=$calls"
+    echo "dropped=$(total 4)"
+    echo "event_bytes=$(stat -c %s "$RESULTS_DIR/events.bin")"
+} | tee "$RESULTS_DIR/bench.txt"
+
+[ "$calls" -ge "$ITERS" ]
@@ -0,0 +1,322 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * credtrack.c - Credential-change Event Tracker
+ *
+ * procinfo reads the caller's credentials once, at load time. credtrack
+ * uses the same conversions (from_kuid/from_kgid in init_user_ns, a walk
+ * of cred->group_info) but records every uid/gid/group change as it
+ * happens, by hooking commit_creds() with ftrace.
+ *
+ * Hot path:
+ *   - commit_creds() runs on every credential update, most of which
+ *     (setting capabilities, keyrings, ...) change no ids at all. That
+ *     case costs one per-CPU increment and five compares.
+ *   - Changes are written to a per-CPU ring preallocated at load time
+ *     (lab_ring.h). No allocation, no shared lock: each CPU is the only
+ *     producer of its own ring. A full ring drops the event and counts it.
+ *
+ * Reader interface:
+ *   /dev/credtrack                  read() returns whole struct credtrack_event
+ *                                   records (see credtrack.h), draining
+ *                                   every CPU's ring. Blocks when empty
+ *                                   unless O_NONBLOCK; poll() supported.
+ *   /sys/kernel/debug/credtrack/stats   per-CPU calls/events/dropped
+ *
+ * Events are ordered per CPU; sort on ts_ns for a global order.
+ *
+ * Usage:
+ *   insmod credtrack.ko
+ *   ./credtrack_read &              # or: cat /dev/credtrack | xxd
+ *   su - student -c id              # triggers several events
+ *   cat /sys/kernel/debug/credtrack/stats
+ *   rmmod credtrack
+ *
+ * Requires: CONFIG_FTRACE=y CONFIG_DYNAMIC_FTRACE=y
+ */
+
+#include <linux/cdev.h>
+#include <linux/cred.h>
+#include <linux/debugfs.h>
+#include <linux/device.h>
+#include <linux/fs.h>
+#include <linux/ftrace.h>
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/percpu.h>
+#include <linux/poll.h>
+#include <linux/sched.h>
+#include <linux/sched/clock.h>
+#include <linux/seq_file.h>
+#include <linux/wait.h>
+
+#include "credtrack.h"
+#include "lab_ring.h"
+
+MODULE_LICENSE("GPL");
+MODULE_AUTHOR("CH0NKY");
+MODULE_DESCRIPTION("ftrace-based credential change tracker");
+MODULE_VERSION("1.0");
+
+#define DEVICE_NAME "credtrack"
+#define CLASS_NAME  "credtrack_class"
+
+/* Events per CPU ring, must be a power of two */
+#define CREDTRACK_RING_SIZE 1024
+
+/* One ring per CPU: credtrack_bufs and its helpers, see lab_ring.h */
+LAB_RING_DEFINE(credtrack, struct credtrack_event, CREDTRACK_RING_SIZE);
+
+struct credtrack_stats {
+	u64 calls;	/* commit_creds() calls seen */
+	u64 events;	/* id/group changes recorded */
+	u64 dropped;	/* changes lost to a full ring */
+};
+
+static DEFINE_PER_CPU(struct credtrack_stats, credtrack_stats);
+
+static DECLARE_WAIT_QUEUE_HEAD(credtrack_wait);
+
+/* Serialises readers, the only writers of each ring's tail */
+static DEFINE_MUTEX(credtrack_read_lock);
+
+static dev_t         dev_num;
+static struct cdev   my_cdev;
+static struct class  *dev_class;
+static struct device *dev_device;
+static struct dentry *debug_dir;
+
+/* ═══════════════════════════════════════════════════════════════════
+ *                        COMMIT_CREDS HOOK
+ * ═══════════════════════════════════════════════════════════════════ */
+
+/* Same conversion as procinfo: kernel ids -> plain ints in init_user_ns */
+static void notrace credtrack_fill_ids(const struct cred *cred, u32 *uid,
+				       u32 *euid, u32 *gid, u32 *egid,
+				       u32 *ngroups, u32 *groups)
+{
+	struct group_info *gi = cred->group_info;
+	int i;
+
+	*uid  = from_kuid(&init_user_ns, cred->uid);
+	*euid = from_kuid(&init_user_ns, cred->euid);
+	*gid  = from_kgid(&init_user_ns, cred->gid);
+	*egid = from_kgid(&init_user_ns, cred->egid);
+
+	*ngroups = gi->ngroups;
+	for (i = 0; i < gi->ngroups && i < CREDTRACK_MAX_GROUPS; i++)
+		groups[i] = from_kgid(&init_user_ns, gi->gid[i]);
+}
+
+/*
+ * Ftrace callback for commit_creds(struct cred *new).
+ *
+ * Runs in the context of the task changing its own credentials, before
+ * the swap: current->real_cred is still the old set.
+ *
+ * prepare_creds() shares group_info with the old cred, so comparing the
+ * pointer catches every setgroups() without walking the arrays.
+ */
+static void notrace credtrack_callback(unsigned long ip,
+				       unsigned long parent_ip,
+				       struct ftrace_ops *op,
+				       struct ftrace_regs *fregs)
+{
+	const struct cred *new = (const struct cred *)ftrace_regs_get_argument(fregs, 0);
+	const struct cred *old = current->real_cred;
+	struct credtrack_event *ev;
+
+	this_cpu_inc(credtrack_stats.calls);
+
+	if (likely(uid_eq(old->uid, new->uid) &&
+		   uid_eq(old->euid, new->euid) &&
+		   gid_eq(old->gid, new->gid) &&
+		   gid_eq(old->egid, new->egid) &&
+		   old->group_info == new->group_info))
+		return;
+
+	preempt_disable_notrace();
+
+	ev = credtrack_reserve();
+	if (!ev) {
+		this_cpu_inc(credtrack_stats.dropped);
+		goto out;
+	}
+
+	ev->ts_ns = local_clock();
+	ev->pid = current->pid;
+	ev->tgid = current->tgid;
+	ev->cpu = smp_processor_id();
+	credtrack_fill_ids(old, &ev->old_uid, &ev->old_euid, &ev->old_gid,
+			   &ev->old_egid, &ev->old_ngroups, ev->old_groups);
+	credtrack_fill_ids(new, &ev->new_uid, &ev->new_euid, &ev->new_gid,
+			   &ev->new_egid, &ev->new_ngroups, ev->new_groups);
+	memcpy(ev->comm, current->comm, CREDTRACK_COMM_LEN);
+
+	credtrack_commit();
+	this_cpu_inc(credtrack_stats.events);
+
+	if (wq_has_sleeper(&credtrack_wait))
+		wake_up_interruptible(&credtrack_wait);
+out:
+	preempt_enable_notrace();
+}
+
+static struct ftrace_ops credtrack_ops = {
+	.func  = credtrack_callback,
+	.flags = FTRACE_OPS_FL_RECURSION,
+};
+
+/* ═══════════════════════════════════════════════════════════════════
+ *                          READER SIDE
+ * ═══════════════════════════════════════════════════════════════════ */
+
+static ssize_t credtrack_read(struct file *file, char __user *buf,
+			      size_t count, loff_t *ppos)
+{
+	ssize_t ret;
+
+	if (count < sizeof(struct credtrack_event))
+		return -EINVAL;
+
+	for (;;) {
+		mutex_lock(&credtrack_read_lock);
+		ret = credtrack_drain(buf, count);
+		mutex_unlock(&credtrack_read_lock);
+
+		if (ret)
+			return ret;
+
+		if (file->f_flags & O_NONBLOCK)
+			return -EAGAIN;
+
+		ret = wait_event_interruptible(credtrack_wait,
+					       credtrack_pending());
+		if (ret)
+			return ret;
+	}
+}
+
+static __poll_t credtrack_poll(struct file *file, poll_table *wait)
+{
+	poll_wait(file, &credtrack_wait, wait);
+	return credtrack_pending() ? EPOLLIN | EPOLLRDNORM : 0;
+}
+
+static const struct file_operations credtrack_fops = {
+	.owner = THIS_MODULE,
+	.read  = credtrack_read,
+	.poll  = credtrack_poll,
+};
+
+/* ═══════════════════════════════════════════════════════════════════
+ *                         DEBUGFS STATS
+ * ═══════════════════════════════════════════════════════════════════ */
+
+static int stats_show(struct seq_file *m, void *v)
+{
+	static const char *const cols[] = { "calls", "events", "dropped" };
+
+	lab_ring_show_stats(m, &credtrack_stats, cols, ARRAY_SIZE(cols));
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(stats);
+
+/* ═══════════════════════════════════════════════════════════════════
+ *                       MODULE INIT / EXIT
+ * ═══════════════════════════════════════════════════════════════════ */
+
+static int __init credtrack_init(void)
+{
+	int ret;
+
+	ret = credtrack_alloc_bufs();
+	if (ret) {
+		pr_err("credtrack: failed to allocate per-CPU rings\n");
+		return ret;
+	}
+
+	ret = alloc_chrdev_region(&dev_num, 0, 1, DEVICE_NAME);
+	if (ret < 0) {
+		pr_err("credtrack: failed to allocate chrdev region: %d\n", ret);
+		goto fail_region;
+	}
+
+	cdev_init(&my_cdev, &credtrack_fops);
+	my_cdev.owner = THIS_MODULE;
+
+	ret = cdev_add(&my_cdev, dev_num, 1);
+	if (ret < 0) {
+		pr_err("credtrack: failed to add cdev: %d\n", ret);
+		goto fail_cdev;
+	}
+
+	dev_class = class_create(CLASS_NAME);
+	if (IS_ERR(dev_class)) {
+		ret = PTR_ERR(dev_class);
+		pr_err("credtrack: failed to create class: %d\n", ret);
+		goto fail_class;
+	}
+
+	dev_device = device_create(dev_class, NULL, dev_num, NULL, DEVICE_NAME);
+	if (IS_ERR(dev_device)) {
+		ret = PTR_ERR(dev_device);
+		pr_err("credtrack: failed to create device: %d\n", ret);
+		goto fail_device;
+	}
+
+	debug_dir = debugfs_create_dir("credtrack", NULL);
+	debugfs_create_file("stats", 0444, debug_dir, NULL, &stats_fops);
+
+	/* commit_creds is exported, so no symbol lookup is needed */
+	ret = ftrace_set_filter_ip(&credtrack_ops, (unsigned long)commit_creds,
+				   0, 0);
+	if (ret) {
+		pr_err("credtrack: failed to set ftrace filter: %d\n", ret);
+		goto fail_ftrace;
+	}
+
+	ret = register_ftrace_function(&credtrack_ops);
+	if (ret) {
+		pr_err("credtrack: failed to register ftrace: %d\n", ret);
+		ftrace_set_filter_ip(&credtrack_ops, (unsigned long)commit_creds,
+				     1, 0);
+		goto fail_ftrace;
+	}
+
+	pr_info("credtrack: hook registered on commit_creds, /dev/%s ready (%d events/CPU)\n",
+		DEVICE_NAME, CREDTRACK_RING_SIZE);
+	return 0;
+
+fail_ftrace:
+	debugfs_remove_recursive(debug_dir);
+	device_destroy(dev_class, dev_num);
+fail_device:
+	class_destroy(dev_class);
+fail_class:
+	cdev_del(&my_cdev);
+fail_cdev:
+	unregister_chrdev_region(dev_num, 1);
+fail_region:
+	credtrack_free_bufs();
+	return ret;
+}
+
+static void __exit credtrack_exit(void)
+{
+	/* Waits for callbacks in flight before the rings go away */
+	unregister_ftrace_function(&credtrack_ops);
+	ftrace_set_filter_ip(&credtrack_ops, (unsigned long)commit_creds, 1, 0);
+
+	debugfs_remove_recursive(debug_dir);
+	device_destroy(dev_class, dev_num);
+	class_destroy(dev_class);
+	cdev_del(&my_cdev);
+	unregister_chrdev_region(dev_num, 1);
+	credtrack_free_bufs();
+	pr_info("credtrack: hook removed\n");
+}
+
+module_init(credtrack_init);
+module_exit(credtrack_exit);
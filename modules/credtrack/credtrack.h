@@ -0,0 +1,33 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * credtrack.h - Event record shared by credtrack.ko and credtrack_read
+ *
+ * Every read() of /dev/credtrack returns a whole number of these records.
+ * The layout is fixed (no implicit padding) so dumps taken from GDB can be
+ * parsed by the same reader.
+ */
+
+#ifndef CREDTRACK_H
+#define CREDTRACK_H
+
+#include <linux/types.h>
+
+#define CREDTRACK_MAX_GROUPS	16
+#define CREDTRACK_COMM_LEN	16
+
+struct credtrack_event {
+	__u64 ts_ns;		/* local_clock() of the writing CPU */
+	__s32 pid;
+	__s32 tgid;
+	__u32 cpu;
+	__u32 old_uid, old_euid, old_gid, old_egid;
+	__u32 new_uid, new_euid, new_gid, new_egid;
+	__u32 old_ngroups;	/* may exceed CREDTRACK_MAX_GROUPS */
+	__u32 new_ngroups;
+	__u32 pad;
+	__u32 old_groups[CREDTRACK_MAX_GROUPS];
+	__u32 new_groups[CREDTRACK_MAX_GROUPS];
+	char comm[CREDTRACK_COMM_LEN];
+};
+
+#endif /* CREDTRACK_H */
@@ -0,0 +1,166 @@
+/*
+ * credtrack_read.c - Userland reader for the credtrack kernel module
+ *
+ * Reads struct credtrack_event records from /dev/credtrack (or from a
+ * file of raw records, or a lab-dump file written by scripts/gdb/lab.py)
+ * and prints one line per event.
+ *
+ * Usage:
+ *   ./credtrack_read              # follow /dev/credtrack (Ctrl-C to stop)
+ *   ./credtrack_read -n           # drain what is buffered, then exit
+ *   ./credtrack_read -f dump.bin  # decode a file of records / a lab-dump
+ *   ./credtrack_read -c           # only print the number of events
+ *
+ * Build (cross-compile for aarch64):
+ *   aarch64-linux-gnu-gcc -Wall -static -o credtrack_read credtrack_read.c
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "credtrack.h"
+
+#define DEVICE "/dev/credtrack"
+
+/* Read this many records per read() call */
+#define BATCH 64
+
+/* Header of a GDB lab-dump file (scripts/gdb/lab.py), little-endian */
+#define DUMP_MAGIC "LABDUMP1"
+
+struct dump_header {
+	char  magic[8];
+	__u32 version;
+	__u32 record_size;
+	__u64 count;
+	char  module[40];
+};
+
+/*
+ * If @fd starts with a lab-dump header, check it and step over it;
+ * otherwise rewind to the first record. Returns -1 on a mismatch.
+ */
+static int skip_dump_header(int fd)
+{
+	struct dump_header hdr;
+
+	if (read(fd, &hdr, sizeof(hdr)) != sizeof(hdr) ||
+	    memcmp(hdr.magic, DUMP_MAGIC, sizeof(hdr.magic)) != 0)
+		return lseek(fd, 0, SEEK_SET) < 0 ? -1 : 0;
+
+	if (hdr.record_size != sizeof(struct credtrack_event)) {
+		fprintf(stderr, "dump of '%.*s': %u-byte records, expected %zu\n",
+			(int)sizeof(hdr.module), hdr.module, hdr.record_size,
+			sizeof(struct credtrack_event));
+		return -1;
+	}
+	return 0;
+}
+
+static void print_groups(const __u32 *groups, __u32 n)
+{
+	__u32 i;
+
+	printf("[");
+	for (i = 0; i < n && i < CREDTRACK_MAX_GROUPS; i++)
+		printf("%s%u", i ? "," : "", groups[i]);
+	if (n > CREDTRACK_MAX_GROUPS)
+		printf(",+%u", n - CREDTRACK_MAX_GROUPS);
+	printf("]");
+}
+
+static void print_id(const char *name, __u32 old, __u32 new)
+{
+	if (old == new)
+		printf(" %s=%u", name, new);
+	else
+		printf(" %s=%u->%u", name, old, new);
+}
+
+static void print_event(const struct credtrack_event *ev)
+{
+	printf("%llu.%06llu cpu%u %d/%d (%.*s)",
+	       (unsigned long long)ev->ts_ns / 1000000000ULL,
+	       (unsigned long long)(ev->ts_ns / 1000) % 1000000ULL,
+	       ev->cpu, ev->tgid, ev->pid, CREDTRACK_COMM_LEN, ev->comm);
+	print_id("uid", ev->old_uid, ev->new_uid);
+	print_id("euid", ev->old_euid, ev->new_euid);
+	print_id("gid", ev->old_gid, ev->new_gid);
+	print_id("egid", ev->old_egid, ev->new_egid);
+	printf(" groups=");
+	print_groups(ev->old_groups, ev->old_ngroups);
+	printf("->");
+	print_groups(ev->new_groups, ev->new_ngroups);
+	printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+	struct credtrack_event ev[BATCH];
+	const char *path = DEVICE;
+	int flags = O_RDONLY;
+	int count_only = 0;
+	unsigned long total = 0;
+	ssize_t n, i;
+	int from_file = 0;
+	int fd, opt;
+
+	while ((opt = getopt(argc, argv, "ncf:")) != -1) {
+		switch (opt) {
+		case 'n':
+			flags |= O_NONBLOCK;
+			break;
+		case 'c':
+			count_only = 1;
+			break;
+		case 'f':
+			path = optarg;
+			from_file = 1;
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-n] [-c] [-f file]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	fd = open(path, flags);
+	if (fd < 0) {
+		perror(path);
+		return 1;
+	}
+
+	if (from_file && skip_dump_header(fd) < 0) {
+		close(fd);
+		return 1;
+	}
+
+	for (;;) {
+		n = read(fd, ev, sizeof(ev));
+		if (n < 0 && errno == EAGAIN)
+			break;
+		if (n < 0) {
+			perror("read");
+			close(fd);
+			return 1;
+		}
+		if (n == 0)
+			break;
+
+		for (i = 0; i < n / (ssize_t)sizeof(ev[0]); i++) {
+			if (!count_only)
+				print_event(&ev[i]);
+			total++;
+		}
+		fflush(stdout);
+	}
+
+	close(fd);
+
+	if (count_only)
+		printf("%lu\n", total);
+	return 0;
+}
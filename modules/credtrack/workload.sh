@@ -0,0 +1,38 @@
+#!/bin/bash
+# ==============================================================================
+# credtrack workload for scripts/test-module.sh
+# ==============================================================================
+# Drops privileges CRED_ITERS times with setpriv (each run commits new
+# uid/gid/groups), times it, and checks the tracker recorded the changes.
+#
+# Environment: MODULE, RESULTS_DIR, CRED_ITERS (default 200)
+# ==============================================================================
+
+set -e
+
+ITERS="${CRED_ITERS:-200}"
+READER="$(dirname "$0")/modules/credtrack_read"
+mkdir -p "$RESULTS_DIR"
+
+# Start from empty rings
+"$READER" -n -c > /dev/null
+
+start=$(date +%s%N)
+for (( i = 0; i < ITERS; i++ )); do
+    setpriv --reuid=65534 --regid=65534 --clear-groups true
+done
+end=$(date +%s%N)
+
+"$READER" -n > "$RESULTS_DIR/events.txt"
+events=$(wc -l < "$RESULTS_DIR/events.txt")
+
+{
+    echo "cred_iters=$ITERS"
+    echo "cred_ns_per_iter=$(( (end - start) / ITERS ))"
+    echo "events=$events"
+} | tee "$RESULTS_DIR/bench.txt"
+
+head -n 5 "$RESULTS_DIR/events.txt"
+
+# Every setpriv commits at least one change (groups, then ids)
+[ "$events" -ge "$ITERS" ]
@@ -0,0 +1,192 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * lab_ring.h - Per-CPU Event Rings for Lab Tracers
+ *
+ * The event plumbing shared by credtrack and the new-module.sh scaffolds.
+ * module.mk puts modules/include on the include path, so every module
+ * builds against this one copy.
+ *
+ * LAB_RING_DEFINE(prefix, struct prefix_event, SIZE); expands to:
+ *
+ *   struct prefix_cpu_buf { u64 head, tail; struct prefix_event ev[SIZE]; };
+ *   static DEFINE_PER_CPU(struct prefix_cpu_buf *, prefix_bufs);
+ *
+ *   prefix_alloc_bufs()    preallocate every CPU's ring (module init)
+ *   prefix_free_bufs()     free them (exit, after the hook is gone)
+ *   prefix_reserve()       producer: next free slot on this CPU, or NULL
+ *   prefix_commit()        producer: publish the reserved slot
+ *   prefix_pending()       reader: any CPU has unread events
+ *   prefix_drain()         reader: copy whole events to user space
+ *
+ * The names are what scripts/gdb/lab.py looks for, so GDB can dump the
+ * rings of any module built on this header.
+ *
+ * Each CPU is the only producer of its own ring, and only writes head;
+ * the reader, serialised by the module's own lock, only writes tail.
+ * The producer must not migrate or be re-entered on its CPU between
+ * reserve and commit: call both with preemption off, or interrupts off
+ * if the hooked function can also run from an interrupt. A full ring
+ * makes reserve() return NULL, and the caller counts the drop.
+ *
+ * lab_ring_show_stats() prints a per-CPU struct of u64 counters as a
+ * debugfs table with a total row.
+ */
+
+#ifndef LAB_RING_H
+#define LAB_RING_H
+
+#include <linux/kernel.h>
+#include <linux/percpu.h>
+#include <linux/seq_file.h>
+#include <linux/topology.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+
+#define LAB_RING_DEFINE(prefix, event_type, size)			\
+									\
+struct prefix##_cpu_buf {						\
+	u64 head;							\
+	u64 tail;							\
+	event_type ev[size];						\
+};									\
+									\
+static DEFINE_PER_CPU(struct prefix##_cpu_buf *, prefix##_bufs);	\
+									\
+static inline void prefix##_free_bufs(void)				\
+{									\
+	int cpu;							\
+									\
+	for_each_possible_cpu(cpu) {					\
+		vfree(per_cpu(prefix##_bufs, cpu));			\
+		per_cpu(prefix##_bufs, cpu) = NULL;			\
+	}								\
+}									\
+									\
+/* Preallocate every ring up front so the hook never allocates */	\
+static inline int prefix##_alloc_bufs(void)				\
+{									\
+	int cpu;							\
+									\
+	for_each_possible_cpu(cpu) {					\
+		struct prefix##_cpu_buf *buf;				\
+									\
+		buf = vzalloc_node(sizeof(*buf), cpu_to_node(cpu));	\
+		if (!buf) {						\
+			prefix##_free_bufs();				\
+			return -ENOMEM;					\
+		}							\
+		per_cpu(prefix##_bufs, cpu) = buf;			\
+	}								\
+	return 0;							\
+}									\
+									\
+static inline event_type *prefix##_reserve(void)			\
+{									\
+	struct prefix##_cpu_buf *buf = this_cpu_read(prefix##_bufs);	\
+	u64 head = buf->head;						\
+									\
+	/* Pairs with the release in _drain() */			\
+	if (head - smp_load_acquire(&buf->tail) >= (size))		\
+		return NULL;						\
+	return &buf->ev[head & ((size) - 1)];				\
+}									\
+									\
+static inline void prefix##_commit(void)				\
+{									\
+	struct prefix##_cpu_buf *buf = this_cpu_read(prefix##_bufs);	\
+									\
+	/* Publish the slot; pairs with the acquire in _drain() */	\
+	smp_store_release(&buf->head, buf->head + 1);			\
+}									\
+									\
+static inline bool prefix##_pending(void)				\
+{									\
+	int cpu;							\
+									\
+	for_each_possible_cpu(cpu) {					\
+		struct prefix##_cpu_buf *buf = per_cpu(prefix##_bufs, cpu); \
+									\
+		if (smp_load_acquire(&buf->head) != buf->tail)		\
+			return true;					\
+	}								\
+	return false;							\
+}									\
+									\
+/*									\
+ * Copy as many whole events as fit in @count from every CPU's ring.	\
+ * Called with the module's read lock held. Returns bytes copied or	\
+ * -EFAULT.								\
+ */									\
+static inline ssize_t prefix##_drain(char __user *ubuf, size_t count)	\
+{									\
+	const size_t sz = sizeof(event_type);				\
+	size_t copied = 0;						\
+	int cpu;							\
+									\
+	for_each_possible_cpu(cpu) {					\
+		struct prefix##_cpu_buf *buf = per_cpu(prefix##_bufs, cpu); \
+		u64 head = smp_load_acquire(&buf->head);		\
+		u64 tail = buf->tail;					\
+									\
+		while (tail != head && copied + sz <= count) {		\
+			if (copy_to_user(ubuf + copied,			\
+					 &buf->ev[tail & ((size) - 1)], sz)) { \
+				smp_store_release(&buf->tail, tail);	\
+				return copied ? copied : -EFAULT;	\
+			}						\
+			copied += sz;					\
+			tail++;						\
+		}							\
+									\
+		/* Hand the slots back to the producer */		\
+		smp_store_release(&buf->tail, tail);			\
+									\
+		if (copied + sz > count)				\
+			break;						\
+	}								\
+									\
+	return copied;							\
+}									\
+									\
+static_assert(((size) & ((size) - 1)) == 0, "ring size: power of two")
+
+/* Columns lab_ring_show_stats() can print */
+#define LAB_STATS_MAX_COLS 8
+
+/*
+ * Print one row per CPU and a total row of the first @ncols u64 members
+ * of the per-CPU struct at @stats, headed by @names. Members after the
+ * first @ncols (histograms, ...) are left to the caller.
+ */
+static inline void lab_ring_show_stats(struct seq_file *m,
+				       const void __percpu *stats,
+				       const char *const *names, int ncols)
+{
+	u64 total[LAB_STATS_MAX_COLS] = {};
+	int cpu, i;
+
+	ncols = min(ncols, LAB_STATS_MAX_COLS);
+
+	seq_printf(m, "%-6s", "cpu");
+	for (i = 0; i < ncols; i++)
+		seq_printf(m, " %12s", names[i]);
+	seq_putc(m, '\n');
+
+	for_each_possible_cpu(cpu) {
+		const u64 *s = per_cpu_ptr(stats, cpu);
+
+		seq_printf(m, "%-6d", cpu);
+		for (i = 0; i < ncols; i++) {
+			seq_printf(m, " %12llu", s[i]);
+			total[i] += s[i];
+		}
+		seq_putc(m, '\n');
+	}
+
+	seq_printf(m, "%-6s", "total");
+	for (i = 0; i < ncols; i++)
+		seq_printf(m, " %12llu", total[i]);
+	seq_putc(m, '\n');
+}
+
+#endif /* LAB_RING_H */
@@ -7,6 +7,9 @@
 #   include ../module.mk
 #
 # Or just put a single .c file in a directory and it auto-detects the name.
+#
+# Headers shared between modules (lab_ring.h, ...) live in modules/include/
+# and are on the include path of every module.
 # ==============================================================================
 
 # Auto-detect module name from directory if not set
@@ -15,6 +18,7 @@ MODULE_NAME ?= $(notdir $(CURDIR))
 # Paths
 MODULES_DIR := $(dir $(lastword $(MAKEFILE_LIST)))
 LAB_ROOT := $(abspath $(MODULES_DIR)/..)
+SHARED_INC := $(abspath $(MODULES_DIR)/include)
 KDIR := $(LAB_ROOT)/linux-6.6
 
 # Toolchain
@@ -25,8 +29,9 @@ CROSS_COMPILE := aarch64-linux-gnu-
 BUILD_DIR := build
 BIN_DIR := bin
 
-# Find all .c files in current directory
+# Find all .c/.h files in current directory
 SRCS := $(wildcard *.c)
+HDRS := $(wildcard *.h)
 
 .PHONY: all clean install
 
@@ -38,8 +43,9 @@ all:
 	fi
 	@echo "=== Building module: $(MODULE_NAME) ==="
 	@mkdir -p $(BUILD_DIR) $(BIN_DIR)
-	@cp $(SRCS) $(BUILD_DIR)/
+	@cp $(SRCS) $(HDRS) $(BUILD_DIR)/
 	@echo "obj-m += $(MODULE_NAME).o" > $(BUILD_DIR)/Makefile
+	@echo "ccflags-y += -I$(SHARED_INC)" >> $(BUILD_DIR)/Makefile
 	@$(MAKE) -C $(KDIR) \
 		M=$(CURDIR)/$(BUILD_DIR) \
 		ARCH=$(ARCH) \
@@ -0,0 +1 @@
+../../scripts/guest/openat-workload.sh
\ No newline at end of file
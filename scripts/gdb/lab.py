@@ -0,0 +1,428 @@
+"""
+lab.py - GDB commands for the lab's tracer modules
+
+Sourced from .gdbinit after vmlinux-gdb.py. Finds loaded modules that
+follow the per-CPU ring layout of modules/include/lab_ring.h, used by
+credtrack and the new-module.sh scaffolds:
+
+    static DEFINE_PER_CPU(struct <m>_cpu_buf *, <m>_bufs);
+    static DEFINE_PER_CPU(struct <m>_stats, <m>_stats);
+
+    struct <m>_cpu_buf { u64 head; u64 tail; struct <m>_event ev[N]; };
+
+and pulls their buffers and counters out of a paused guest. Each CPU's
+ring is fetched with a single memory read and cut into records on the
+host, so a post-mortem dump costs one round trip per CPU rather than one
+per field.
+
+Addresses come from the module's own kallsyms in guest memory
+(CONFIG_KALLSYMS_ALL, set by setup_kernel.sh), or failing that from the
+module's .ko under modules/ plus mod->percpu. Struct layouts come from the
+module's debug info, loaded with 'lx-symbols modules' (done for you if
+the types are missing).
+
+Commands:
+  lab-tracers                      list tracer modules and ring fill
+  lab-stats MODULE                 per-CPU counters
+  lab-dump [--all] MODULE FILE     events to FILE (binary, see below)
+  lab-dump-all [--all] DIR         every tracer: DIR/<m>.bin, <m>.stats.txt
+
+Modules without that layout - trace_openat and trace_openat_ftrace log
+each call with pr_info and keep no ring - can't be dumped; lab-tracers
+lists them with the reason.
+
+By default only unread events (tail..head) are dumped, which is what a
+reader would have got next. --all dumps everything still in the ring,
+including slots a reader already consumed.
+
+Dump file format (little-endian), followed by 'count' raw records in ring
+order, CPU by CPU (sort on the timestamp for a global order):
+
+    char magic[8];        "LABDUMP1"
+    u32  version;         1
+    u32  record_size;     sizeof(struct <m>_event)
+    u64  count;
+    char module[40];      NUL-padded
+"""
+
+import os
+import struct
+
+import gdb
+
+from linux import cpus, modules
+
+DUMP_MAGIC = b"LABDUMP1"
+DUMP_VERSION = 1
+DUMP_HEADER = struct.Struct("<8sIIQ40s")
+
+# Elf64_Sym: st_name, st_info, st_other, st_shndx, st_value, st_size
+ELF64_SYM = struct.Struct("<IBBHQQ")
+# Elf64_Shdr: name, type, flags, addr, offset, size, link, info, align, entsize
+ELF64_SHDR = struct.Struct("<IIQQQQIIQQ")
+SHT_SYMTAB = 2
+
+LAB_ROOT = os.path.dirname(os.path.dirname(os.path.dirname(
+    os.path.abspath(__file__))))
+
+_symbols_loaded = False
+
+
+def _kallsyms_symbols(mod, wanted):
+    """Look up 'wanted' names in the module's kallsyms, return name -> addr.
+
+    The kernel has already relocated these: a per-CPU symbol's value is
+    mod->percpu + offset, i.e. a __percpu pointer. Without
+    CONFIG_KALLSYMS_ALL only text symbols are kept and nothing is found.
+    """
+    kallsyms = mod["kallsyms"].dereference()
+    num = int(kallsyms["num_symtab"])
+    symtab = int(kallsyms["symtab"])
+    strtab = int(kallsyms["strtab"])
+    if num == 0:
+        return {}
+
+    inf = gdb.selected_inferior()
+    syms = list(ELF64_SYM.iter_unpack(
+        inf.read_memory(symtab, num * ELF64_SYM.size).tobytes()))
+    strings = inf.read_memory(
+        strtab, max(s[0] for s in syms) + 1).tobytes()
+
+    found = {}
+    for st_name, _, _, _, st_value, _ in syms:
+        for name in wanted:
+            key = name.encode() + b"\0"
+            chunk = strings[st_name:st_name + len(key)]
+            if len(chunk) < len(key):
+                chunk = inf.read_memory(strtab + st_name, len(key)).tobytes()
+            if chunk == key:
+                found[name] = st_value
+    return found
+
+
+def _ko_percpu_symbols(mod, name, wanted):
+    """Fallback: offsets of 'wanted' in the .ko's .data..percpu + mod->percpu.
+
+    Returns None when there is no .ko with a symbol table to search.
+    """
+    ko = os.path.join(LAB_ROOT, "modules", name, "bin", name + ".ko")
+    try:
+        with open(ko, "rb") as f:
+            elf = f.read()
+    except OSError:
+        return None
+
+    shoff, = struct.unpack_from("<Q", elf, 0x28)
+    shnum, shstrndx = struct.unpack_from("<HH", elf, 0x3c)
+    shdrs = [ELF64_SHDR.unpack_from(elf, shoff + i * ELF64_SHDR.size)
+             for i in range(shnum)]
+
+    def section_name(i):
+        start = shdrs[shstrndx][4] + shdrs[i][0]
+        return elf[start:elf.index(b"\0", start)]
+
+    symtab = next((h for h in shdrs if h[1] == SHT_SYMTAB), None)
+    if symtab is None:
+        return None
+    strtab = shdrs[symtab[6]][4]
+
+    found = {}
+    for off in range(symtab[4], symtab[4] + symtab[5], ELF64_SYM.size):
+        st_name, _, _, st_shndx, st_value, _ = ELF64_SYM.unpack_from(elf, off)
+        sym = elf[strtab + st_name:elf.index(b"\0", strtab + st_name)]
+        if (sym.decode() in wanted and st_shndx < shnum
+                and section_name(st_shndx) == b".data..percpu"):
+            found[sym.decode()] = int(mod["percpu"]) + st_value
+    return found
+
+
+def _module_symbols(mod, name, wanted):
+    """Return (name -> addr, whether data symbols could be searched at all).
+
+    __this_module is a data symbol every module has: if kallsyms holds it,
+    kallsyms covers data and a missing name really is missing.
+    """
+    found = _kallsyms_symbols(mod, wanted + ("__this_module",))
+    searched = found.pop("__this_module", None) is not None
+    if len(found) < len(wanted):
+        ko = _ko_percpu_symbols(mod, name, wanted)
+        if ko is not None:
+            searched = True
+            for sym, addr in ko.items():
+                found.setdefault(sym, addr)
+    return found, searched
+
+
+def _lookup_type(name):
+    global _symbols_loaded
+
+    try:
+        return gdb.lookup_type(name)
+    except gdb.error:
+        pass
+    if not _symbols_loaded:
+        _symbols_loaded = True
+        gdb.write("lab: loading module symbols from %s/modules\n" % LAB_ROOT)
+        gdb.execute("lx-symbols %s/modules" % LAB_ROOT, to_string=True)
+        try:
+            return gdb.lookup_type(name)
+        except gdb.error:
+            pass
+    raise gdb.GdbError("lab: no debug info for '%s' - build the module "
+                       "and run 'lx-symbols modules'" % name)
+
+
+def _percpu_addr(ptr, cpu):
+    offset = gdb.parse_and_eval("__per_cpu_offset[%d]" % cpu)
+    return (ptr + int(offset)) & 0xffffffffffffffff
+
+
+def _read_u64(addr):
+    return struct.unpack(
+        "<Q", gdb.selected_inferior().read_memory(addr, 8).tobytes())[0]
+
+
+class Tracer:
+    """A loaded module with <m>_bufs/<m>_stats per-CPU variables."""
+
+    def __init__(self, name, bufs, stats):
+        self.name = name
+        self.bufs = bufs
+        self.stats = stats
+        self._layout = None
+
+    def layout(self):
+        """(sizeof cpu_buf, ev offset, record size, ring size) from debug info."""
+        if self._layout is None:
+            buf_type = _lookup_type("struct %s_cpu_buf" % self.name)
+            ev = next(f for f in buf_type.fields() if f.name == "ev")
+            lo, hi = ev.type.range()
+            self._layout = (buf_type.sizeof, ev.bitpos // 8,
+                            ev.type.target().sizeof, hi - lo + 1)
+        return self._layout
+
+    def rings(self):
+        """Yield (cpu, head, tail, raw ring bytes) with one read per CPU."""
+        inf = gdb.selected_inferior()
+        size = self.layout()[0]
+
+        for cpu in cpus.each_possible_cpu():
+            buf = _read_u64(_percpu_addr(self.bufs, cpu))
+            if buf == 0:
+                continue
+            raw = inf.read_memory(buf, size).tobytes()
+            head, tail = struct.unpack_from("<QQ", raw, 0)
+            yield cpu, head, tail, raw
+
+    def events(self, everything=False):
+        """Yield (cpu, record count, record bytes) in ring order."""
+        _, ev_off, rec_size, ring_size = self.layout()
+
+        for cpu, head, tail, raw in self.rings():
+            start = max(head - ring_size, 0) if everything else tail
+            if head - start > ring_size:
+                start = head - ring_size
+            n = head - start
+            if n <= 0:
+                continue
+
+            first = start & (ring_size - 1)
+            run = min(n, ring_size - first)
+            chunks = [raw[ev_off + first * rec_size:
+                          ev_off + (first + run) * rec_size]]
+            if run < n:
+                chunks.append(raw[ev_off:ev_off + (n - run) * rec_size])
+            yield cpu, n, b"".join(chunks)
+
+    def stats_rows(self):
+        """Yield (cpu, gdb.Value of struct <m>_stats), one read per CPU."""
+        if self.stats is None:
+            return
+        stats_type = _lookup_type("struct %s_stats" % self.name)
+        inf = gdb.selected_inferior()
+
+        for cpu in cpus.each_possible_cpu():
+            raw = inf.read_memory(_percpu_addr(self.stats, cpu),
+                                  stats_type.sizeof).tobytes()
+            yield cpu, gdb.Value(raw, stats_type)
+
+    def format_stats(self):
+        rows = list(self.stats_rows())
+        if not rows:
+            return "%s: no %s_stats\n" % (self.name, self.name)
+
+        fields = rows[0][1].type.fields()
+        scalars = [f.name for f in fields if f.type.code != gdb.TYPE_CODE_ARRAY]
+        arrays = [f for f in fields if f.type.code == gdb.TYPE_CODE_ARRAY]
+
+        out = ["%-6s" % "cpu" + "".join(" %12s" % n for n in scalars)]
+        totals = [0] * len(scalars)
+        for cpu, value in rows:
+            vals = [int(value[n]) for n in scalars]
+            totals = [t + v for t, v in zip(totals, vals)]
+            out.append("%-6d" % cpu + "".join(" %12d" % v for v in vals))
+        out.append("%-6s" % "total" + "".join(" %12d" % v for v in totals))
+
+        for f in arrays:
+            lo, hi = f.type.range()
+            for i in range(lo, hi + 1):
+                n = sum(int(value[f.name][i]) for _, value in rows)
+                if n:
+                    out.append("%s[%d] %d" % (f.name, i, n))
+        return "\n".join(out) + "\n"
+
+    def dump(self, path, everything=False):
+        rec_size = self.layout()[2]
+        count = 0
+
+        with open(path, "wb") as f:
+            f.write(b"\0" * DUMP_HEADER.size)
+            for _, n, data in self.events(everything):
+                f.write(data)
+                count += n
+            f.seek(0)
+            f.write(DUMP_HEADER.pack(DUMP_MAGIC, DUMP_VERSION, rec_size,
+                                     count, self.name.encode()[:39]))
+        return count, rec_size
+
+
+def find_tracers():
+    """Return (tracers, [(module, why it can't be dumped)])."""
+    tracers = []
+    skipped = []
+    for mod in modules.module_list():
+        name = mod["name"].string()
+        syms, searched = _module_symbols(
+            mod, name, (name + "_bufs", name + "_stats"))
+        if name + "_bufs" in syms:
+            tracers.append(Tracer(name, syms[name + "_bufs"],
+                                  syms.get(name + "_stats")))
+        elif searched:
+            skipped.append((name, "no per-CPU %s_bufs ring "
+                                  "(not built on lab_ring.h)" % name))
+        else:
+            skipped.append((name, "can't see its data symbols: kernel "
+                                  "without CONFIG_KALLSYMS_ALL and no "
+                                  "modules/%s/bin/%s.ko" % (name, name)))
+    return tracers, skipped
+
+
+def find_tracer(name):
+    tracers, skipped = find_tracers()
+    for t in tracers:
+        if t.name == name:
+            return t
+    for mod, why in skipped:
+        if mod == name:
+            raise gdb.GdbError("lab: can't dump '%s': %s" % (name, why))
+    raise gdb.GdbError("lab: '%s' is not loaded" % name)
+
+
+def _write_skipped(skipped):
+    if skipped:
+        gdb.write("Loaded, not dumpable:\n")
+        for name, why in skipped:
+            gdb.write("  %s: %s\n" % (name, why))
+
+
+def _split_all(arg, nargs, usage):
+    argv = gdb.string_to_argv(arg)
+    everything = "--all" in argv
+    argv = [a for a in argv if a != "--all"]
+    if len(argv) != nargs:
+        raise gdb.GdbError("usage: " + usage)
+    return everything, argv
+
+
+class LabTracers(gdb.Command):
+    """List loaded tracer modules and how full their per-CPU rings are.
+
+lab-tracers
+
+A tracer module is one with a per-CPU <name>_bufs ring pointer
+(modules/include/lab_ring.h). Other loaded modules are listed with the
+reason they can't be dumped."""
+
+    def __init__(self):
+        super(LabTracers, self).__init__("lab-tracers", gdb.COMMAND_DATA)
+
+    def invoke(self, arg, from_tty):
+        tracers, skipped = find_tracers()
+        if not tracers:
+            gdb.write("No tracer modules loaded.\n")
+        for t in tracers:
+            _, _, rec_size, ring_size = t.layout()
+            gdb.write("%s: %d-byte events, %d per CPU\n"
+                      % (t.name, rec_size, ring_size))
+            for cpu, head, tail, _ in t.rings():
+                gdb.write("  cpu%-3d head %10d tail %10d unread %6d\n"
+                          % (cpu, head, tail, head - tail))
+        _write_skipped(skipped)
+
+
+class LabStats(gdb.Command):
+    """Print a tracer module's per-CPU counters.
+
+lab-stats MODULE"""
+
+    def __init__(self):
+        super(LabStats, self).__init__("lab-stats", gdb.COMMAND_DATA)
+
+    def invoke(self, arg, from_tty):
+        argv = gdb.string_to_argv(arg)
+        if len(argv) != 1:
+            raise gdb.GdbError("usage: lab-stats MODULE")
+        gdb.write(find_tracer(argv[0]).format_stats())
+
+
+class LabDump(gdb.Command):
+    """Dump a tracer module's buffered events to a host file.
+
+lab-dump [--all] MODULE FILE
+
+Writes a LABDUMP1 header and the raw event records (see scripts/gdb/lab.py).
+--all includes events a reader already consumed that are still in the ring."""
+
+    def __init__(self):
+        super(LabDump, self).__init__("lab-dump", gdb.COMMAND_DATA,
+                                      gdb.COMPLETE_FILENAME)
+
+    def invoke(self, arg, from_tty):
+        everything, (name, path) = _split_all(
+            arg, 2, "lab-dump [--all] MODULE FILE")
+        count, rec_size = find_tracer(name).dump(path, everything)
+        gdb.write("%s: %d events (%d bytes) -> %s\n"
+                  % (name, count, count * rec_size, path))
+
+
+class LabDumpAll(gdb.Command):
+    """Dump events and counters of every tracer module into a directory.
+
+lab-dump-all [--all] DIR
+
+Writes DIR/<module>.bin (as lab-dump) and DIR/<module>.stats.txt."""
+
+    def __init__(self):
+        super(LabDumpAll, self).__init__("lab-dump-all", gdb.COMMAND_DATA,
+                                         gdb.COMPLETE_FILENAME)
+
+    def invoke(self, arg, from_tty):
+        everything, (out_dir,) = _split_all(arg, 1,
+                                            "lab-dump-all [--all] DIR")
+        os.makedirs(out_dir, exist_ok=True)
+        tracers, skipped = find_tracers()
+        if not tracers:
+            gdb.write("No tracer modules loaded.\n")
+        for t in tracers:
+            path = os.path.join(out_dir, t.name + ".bin")
+            count, _ = t.dump(path, everything)
+            with open(os.path.join(out_dir, t.name + ".stats.txt"), "w") as f:
+                f.write(t.format_stats())
+            gdb.write("%s: %d events -> %s\n" % (t.name, count, path))
+        _write_skipped(skipped)
+
+
+LabTracers()
+LabStats()
+LabDump()
+LabDumpAll()
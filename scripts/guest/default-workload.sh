@@ -0,0 +1,23 @@
+#!/bin/bash
+# ==============================================================================
+# Default guest workload for scripts/test-module.sh
+# ==============================================================================
+# Runs inside the guest. Exercises a bit of everything (file opens, process
+# creation) so a freshly loaded module sees some activity, and records the
+# module's kernel log lines.
+#
+# Environment: MODULE, RESULTS_DIR
+# ==============================================================================
+
+set -e
+
+mkdir -p "$RESULTS_DIR"
+
+for i in $(seq 100); do
+    cat /etc/hostname > /dev/null
+    /bin/true
+done
+
+grep -F "$MODULE" /proc/modules
+dmesg | grep -F "$MODULE" > "$RESULTS_DIR/module-log.txt" || true
+echo "log_lines=$(wc -l < "$RESULTS_DIR/module-log.txt")"
@@ -0,0 +1,48 @@
+#!/bin/bash
+# ==============================================================================
+# openat workload for scripts/test-module.sh
+# ==============================================================================
+# Times OPENAT_ITERS opens of /etc/hostname with an openat tracer loaded
+# and checks that $MODULE logged them. Used by trace_openat and
+# trace_openat_ftrace (their workload.sh links here).
+#
+# With target_pid set to another process the tracer must stay quiet about
+# our opens instead, so the check flips to "logged none".
+#
+# Environment: MODULE, RESULTS_DIR, OPENAT_ITERS (default 5000)
+# ==============================================================================
+
+set -e
+
+ITERS="${OPENAT_ITERS:-5000}"
+mkdir -p "$RESULTS_DIR"
+
+start=$(date +%s%N)
+for (( i = 0; i < ITERS; i++ )); do
+    : < /etc/hostname
+done
+end=$(date +%s%N)
+
+logged=$(dmesg | grep -c "$MODULE: .*/etc/hostname" || true)
+
+# The opens are builtin redirects, so they all come from this shell's PID
+target_pid=$(cat "/sys/module/$MODULE/parameters/target_pid" 2>/dev/null || echo 0)
+if [ "$target_pid" -gt 0 ] && [ "$target_pid" -ne $$ ]; then
+    expect="none"
+else
+    expect="some"
+fi
+
+{
+    echo "openat_iters=$ITERS"
+    echo "openat_ns_per_op=$(( (end - start) / ITERS ))"
+    echo "target_pid=$target_pid"
+    echo "logged=$logged"
+} | tee "$RESULTS_DIR/bench.txt"
+
+# The kernel log ring can wrap, but it must have seen the opens
+if [ "$expect" = "none" ]; then
+    [ "$logged" -eq 0 ]
+else
+    [ "$logged" -gt 0 ]
+fi
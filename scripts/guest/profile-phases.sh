@@ -0,0 +1,93 @@
+#!/bin/bash
+# ==============================================================================
+# Guest side of scripts/profile.sh
+# ==============================================================================
+# Runs every profiling phase from this one process, so a measured phase
+# sees the openat loop and nothing else of ours: no SSH login, no PAM, no
+# shell startup, no poke to make the plugin notice a switch.
+#
+# The control file and the plugin's output sit in the shared folder and are
+# opened once, up front. Switching phase is a single write() appending a
+# block to ctl; waiting for the plugin is read()s on its output. Neither
+# opens a file, so __arm64_sys_openat only counts the loop's opens (plus
+# whatever the rest of the idle guest does).
+#
+# Usage: profile-phases.sh DIR OPENS [module...]
+#
+#   DIR/ctl, DIR/profile.txt   plugin control file and output
+#   DIR/kernel.track           track lines used in every phase
+#   DIR/<module>.funcs         "offset name" of the module functions to track
+#   DIR/<module>.base          written here: load address of .text
+#   $VM_SHARE_MOUNT/modules/<module>.ko
+# ==============================================================================
+
+set -e
+
+DIR="$1"
+OPENS="$2"
+shift 2
+
+KO_DIR="$(dirname "$DIR")/modules"
+KERNEL_TRACK="$(< "$DIR/kernel.track")"
+
+exec 3< "$DIR/profile.txt"
+exec 4>> "$DIR/ctl"
+
+# switch_phase <name> [track lines] - one append to ctl, then read the
+# plugin's output until it confirms
+switch_phase() {
+    local want="# phase $1 begin"
+    local line partial=""
+    local start=$SECONDS
+
+    printf 'phase %s\n%s\n%s' "$1" "$KERNEL_TRACK" "${2:+$2$'\n'}" >&4
+
+    # Every read is a syscall, so the plugin gets the kernel TBs it polls from
+    while (( SECONDS - start < 120 )); do
+        if IFS= read -r -u 3 line; then
+            [ "$partial$line" = "$want" ] && return 0
+            partial=""
+        else
+            # EOF mid-line: keep the fragment for the next read
+            partial+="$line"
+        fi
+    done
+    echo "Error: plugin did not pick up phase '$1'" >&2
+    exit 1
+}
+
+# open_loop - the measured workload, one builtin redirect per open
+open_loop() {
+    local i
+
+    for (( i = 0; i < OPENS; i++ )); do
+        : < /etc/hostname
+    done
+}
+
+echo ">>> Phase baseline ($OPENS opens)"
+switch_phase baseline
+open_loop
+
+for m in "$@"; do
+    switch_phase "load-$m"
+    insmod "$KO_DIR/$m.ko"
+
+    base="$(< "/sys/module/$m/sections/.text")"
+    echo "$base" > "$DIR/$m.base"
+    tracks=""
+    while read -r off name; do
+        # 64-bit wraparound in bash arithmetic still prints correctly
+        printf -v line 'track %s %016x\n' "$name" $(( base + 0x$off ))
+        tracks+="$line"
+    done < "$DIR/$m.funcs"
+
+    echo ">>> Phase $m ($OPENS opens)"
+    switch_phase "$m" "${tracks%$'\n'}"
+    open_loop
+
+    switch_phase "unload-$m"
+    rmmod "$m"
+done
+
+switch_phase end
@@ -0,0 +1,289 @@
+#!/bin/bash
+
+# ==============================================================================
+# AArch64 Lab - Parallel Multi-VM Runner
+# ==============================================================================
+# Boots N VMs side by side and spreads a list of jobs across them.
+#
+# Each run gets a fresh vms/multi.XXXXXX/ (removed afterwards) and each VM
+# its own instance directory in it:
+#   vm<i>/disk.qcow2    Thin overlay on the golden image (fresh per run)
+#   vm<i>/shared/       Private copy of ./shared (mounted at /mnt/shared)
+#   vm<i>/qmp.sock      QMP control socket
+#   vm<i>/serial.log    Serial console (copied to the results)
+#
+# and its own ports: SSH and GDB (not paused) on the next free ports from
+# SSH_BASE and GDB_BASE, skipping any that are already in use.
+#
+# Job file format - one job per line, '#' starts a comment:
+#   <name> <command run in the guest from /mnt/shared>
+#
+# Usage:
+#   ./scripts/multi-run.sh [OPTIONS] <jobfile>
+# ==============================================================================
+
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+LAB_ROOT="$(dirname "$SCRIPT_DIR")"
+GOLDEN_IMAGE="$LAB_ROOT/debian-rootfs.qcow2"
+SHARE_DIR="$LAB_ROOT/shared"
+VMS_DIR="$LAB_ROOT/vms"
+
+# shellcheck source=vm-lib.sh
+source "$SCRIPT_DIR/vm-lib.sh"
+
+# Colors
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+NC='\033[0m' # No Color
+
+# Defaults
+NPROC="$(nproc)"
+VMS=$(( NPROC / 2 > 0 ? NPROC / 2 : 1 ))
+CPUS="2"
+MEMORY="1G"
+SSH_BASE="${SSH_BASE:-10100}"
+GDB_BASE="${GDB_BASE:-1300}"
+BOOT_TIMEOUT="300"
+JOB_TIMEOUT="600"
+OUT_DIR=""
+
+usage() {
+    echo "Usage: $0 [OPTIONS] <jobfile>"
+    echo ""
+    echo "Options:"
+    echo "  --vms N            Number of VMs (default: nproc/2 = $VMS)"
+    echo "  --cpus N           vCPUs per VM (default: $CPUS)"
+    echo "  --mem SIZE         Memory per VM (default: $MEMORY)"
+    echo "  --out DIR          Results directory (default: results/multi-<time>)"
+    echo "  --boot-timeout S   Seconds to wait for SSH (default: $BOOT_TIMEOUT)"
+    echo "  --job-timeout S    Seconds per job (default: $JOB_TIMEOUT)"
+    echo ""
+    echo "Ports: VMs take the next free SSH port from \$SSH_BASE ($SSH_BASE) and GDB"
+    echo "port from \$GDB_BASE ($GDB_BASE); busy ports are skipped."
+    echo ""
+    echo "Job file (one per line):"
+    echo "  insmod-hello  insmod modules/hello.ko && rmmod hello"
+    echo ""
+    echo "Examples:"
+    echo "  $0 scripts/jobs/modules.jobs"
+    echo "  $0 --vms 4 --cpus 1 my-sweep.jobs"
+}
+
+# --- Parse Arguments ---
+JOBFILE=""
+while [[ $# -gt 0 ]]; do
+    case "$1" in
+        --vms)
+            VMS="$2"
+            shift 2
+            ;;
+        --cpus)
+            CPUS="$2"
+            shift 2
+            ;;
+        --mem)
+            MEMORY="$2"
+            shift 2
+            ;;
+        --out)
+            OUT_DIR="$2"
+            shift 2
+            ;;
+        --boot-timeout)
+            BOOT_TIMEOUT="$2"
+            shift 2
+            ;;
+        --job-timeout)
+            JOB_TIMEOUT="$2"
+            shift 2
+            ;;
+        --help|-h)
+            usage
+            exit 0
+            ;;
+        -*)
+            echo "Unknown option: $1"
+            echo "Use --help for usage information."
+            exit 1
+            ;;
+        *)
+            JOBFILE="$1"
+            shift
+            ;;
+    esac
+done
+
+if [ -z "$JOBFILE" ]; then
+    usage
+    exit 1
+fi
+
+if [ ! -f "$JOBFILE" ]; then
+    echo -e "${RED}Error: Job file not found: $JOBFILE${NC}"
+    exit 1
+fi
+
+if [ ! -f "$GOLDEN_IMAGE" ]; then
+    echo -e "${RED}Error: Golden image not found: $GOLDEN_IMAGE${NC}"
+    echo "Run 'sudo ./setup/setup_debian.sh' first."
+    exit 1
+fi
+
+vm_require_tools
+
+OUT_DIR="${OUT_DIR:-$LAB_ROOT/results/multi-$(date +%Y%m%d-%H%M%S)}"
+mkdir -p "$OUT_DIR/jobs"
+
+# --- Job Queue ---
+# Workers pop lines from a shared queue file under flock, so fast VMs
+# simply take more jobs.
+QUEUE="$OUT_DIR/.queue"
+grep -v -e '^[[:space:]]*#' -e '^[[:space:]]*$' "$JOBFILE" > "$QUEUE" || true
+NJOBS=$(wc -l < "$QUEUE")
+
+if [ "$NJOBS" -eq 0 ]; then
+    echo -e "${RED}Error: No jobs in $JOBFILE${NC}"
+    exit 1
+fi
+
+# Never boot more VMs than there are jobs
+if [ "$VMS" -gt "$NJOBS" ]; then
+    VMS="$NJOBS"
+fi
+
+next_job() {
+    (
+        flock 9
+        local line
+        line="$(head -n 1 "$QUEUE")"
+        [ -n "$line" ] || exit 1
+        sed -i '1d' "$QUEUE"
+        printf '%s\n' "$line"
+    ) 9> "$QUEUE.lock"
+}
+
+# --- Cleanup Trap ---
+RUN_DIR="$(vm_instance_dir "$VMS_DIR" multi)"
+QEMU_PIDS=()
+SSH_PORTS=()
+cleanup() {
+    local i
+    for i in "${!QEMU_PIDS[@]}"; do
+        vm_stop "${QEMU_PIDS[$i]}" "$RUN_DIR/vm$i/qmp.sock"
+        cp "$RUN_DIR/vm$i/serial.log" "$OUT_DIR/vm$i-serial.log" 2>/dev/null || true
+    done
+    rm -rf "$RUN_DIR"
+    rm -f "$QUEUE" "$QUEUE.lock"
+}
+trap cleanup EXIT
+
+# --- Boot Instances ---
+echo "=============================================================================="
+echo "  AArch64 Lab - Multi-VM Runner"
+echo "=============================================================================="
+echo ""
+echo "  Jobs:       $NJOBS ($JOBFILE)"
+echo "  VMs:        $VMS x ${CPUS} vCPU, $MEMORY"
+echo "  Results:    $OUT_DIR"
+echo ""
+
+ssh_port=$SSH_BASE
+gdb_port=$GDB_BASE
+for (( i = 0; i < VMS; i++ )); do
+    ssh_port="$(vm_find_port "$ssh_port")" || exit 1
+    gdb_port="$(vm_find_port "$gdb_port")" || exit 1
+    SSH_PORTS[$i]=$ssh_port
+
+    inst="$RUN_DIR/vm$i"
+    mkdir -p "$inst/shared"
+    cp -a "$SHARE_DIR/." "$inst/shared/" 2>/dev/null || true
+    vm_create_overlay "$inst/disk.qcow2" "$GOLDEN_IMAGE"
+
+    "$SCRIPT_DIR/start.sh" \
+        --image "$inst/disk.qcow2" \
+        --share-dir "$inst/shared" \
+        --ssh-port "$ssh_port" \
+        --gdb-port "$gdb_port" \
+        --gdb-nowait \
+        --qmp "$inst/qmp.sock" \
+        --serial-log "$inst/serial.log" \
+        --cpus "$CPUS" \
+        --mem "$MEMORY" \
+        > "$inst/start.log" 2>&1 < /dev/null &
+    QEMU_PIDS[$i]=$!
+
+    echo ">>> vm$i: pid ${QEMU_PIDS[$i]}, ssh $ssh_port, gdb $gdb_port"
+    ssh_port=$(( ssh_port + 1 ))
+    gdb_port=$(( gdb_port + 1 ))
+done
+echo ""
+
+# --- Workers ---
+# run_worker <index> - wait for the VM, then drain the queue
+run_worker() {
+    local i="$1"
+    local port="${SSH_PORTS[$i]}"
+    local pid="${QEMU_PIDS[$i]}"
+    local line name cmd start rc err
+
+    if ! vm_wait_ssh "$port" "$pid" "$BOOT_TIMEOUT"; then
+        echo -e "${RED}>>> vm$i: did not come up (see $OUT_DIR/vm$i-serial.log)${NC}"
+        return 1
+    fi
+    # Checked by hand: set -e would end the worker without a word
+    if ! err="$(vm_ssh "$port" "mount-shared" 2>&1 > /dev/null)"; then
+        printf 'vm%d: mount-shared failed\n%s\n' "$i" "$err" > "$OUT_DIR/vm$i-mount.log"
+        echo -e "${RED}>>> vm$i: mount-shared failed (see $OUT_DIR/vm$i-mount.log)${NC}"
+        return 1
+    fi
+
+    while line="$(next_job)"; do
+        name="${line%%[[:space:]]*}"
+        cmd="${line#"$name"}"
+        start=$SECONDS
+
+        rc=0
+        vm_ssh_timeout "$JOB_TIMEOUT" "$port" "cd $VM_SHARE_MOUNT && $cmd" \
+            < /dev/null > "$OUT_DIR/jobs/$name.log" 2>&1 || rc=$?
+
+        printf '%s\tvm%d\t%d\t%d\n' "$name" "$i" "$rc" $(( SECONDS - start )) \
+            >> "$OUT_DIR/results.tsv"
+        if [ "$rc" -eq 0 ]; then
+            echo -e "    ${GREEN}PASS${NC} $name (vm$i, $(( SECONDS - start ))s)"
+        else
+            echo -e "    ${RED}FAIL${NC} $name (vm$i, rc=$rc)"
+        fi
+    done
+
+    # Keep the guest's view of the run next to the job logs
+    vm_ssh "$port" "dmesg" > "$OUT_DIR/vm$i-dmesg.log" 2>&1 || true
+}
+
+printf 'job\tvm\trc\tseconds\n' > "$OUT_DIR/results.tsv"
+
+WORKERS=()
+for (( i = 0; i < VMS; i++ )); do
+    run_worker "$i" &
+    WORKERS+=($!)
+done
+
+for pid in "${WORKERS[@]}"; do
+    wait "$pid" || true
+done
+
+# --- Summary ---
+DONE=$(( $(wc -l < "$OUT_DIR/results.tsv") - 1 ))
+FAILED=$(awk -F'\t' 'NR > 1 && $3 != 0' "$OUT_DIR/results.tsv" | wc -l)
+MISSED=$(( NJOBS - DONE ))
+
+echo ""
+echo "=============================================================================="
+echo "  Jobs: $NJOBS   Passed: $(( DONE - FAILED ))   Failed: $FAILED   Not run: $MISSED"
+echo "  Results: $OUT_DIR/results.tsv"
+echo "=============================================================================="
+
+if [ "$FAILED" -ne 0 ] || [ "$MISSED" -ne 0 ]; then
+    exit 1
+fi
@@ -3,7 +3,7 @@
 # ==============================================================================
 # Create a New Kernel Module
 # ==============================================================================
-# Usage: ./scripts/new-module.sh <module_name>
+# Usage: ./scripts/new-module.sh [--kind=tracer|chardev|stats] <module_name>
 # ==============================================================================
 
 set -e
@@ -18,27 +18,78 @@ RED='\033[0;31m'
 GREEN='\033[0;32m'
 NC='\033[0m'
 
+KIND=""
+MODULE_NAME=""
+
 usage() {
-    echo "Usage: $0 <module_name>"
+    echo "Usage: $0 [--kind=KIND] <module_name>"
     echo ""
     echo "Creates a new kernel module from template."
     echo ""
+    echo "Kinds (default: bare init/exit skeleton):"
+    echo "  tracer    ftrace hook on one function, per-CPU event rings"
+    echo "  chardev   /dev/<name> recording writes into per-CPU event rings"
+    echo "  stats     kretprobe latency histogram, slow calls to event rings"
+    echo ""
+    echo "Every kind has per-CPU counters in /sys/kernel/debug/<name>/stats,"
+    echo "preallocated per-CPU rings, and a workload.sh for 'make test'."
+    echo ""
     echo "Example:"
     echo "  $0 mydriver"
+    echo "  $0 --kind=tracer mytracer"
     echo ""
     echo "This creates:"
     echo "  modules/mydriver/Makefile"
     echo "  modules/mydriver/mydriver.c"
+    echo "  modules/mydriver/workload.sh   (with --kind)"
 }
 
-if [ -z "$1" ]; then
+# --- Parse Arguments ---
+while [[ $# -gt 0 ]]; do
+    case "$1" in
+        --kind=*)
+            KIND="${1#--kind=}"
+            shift
+            ;;
+        --kind)
+            KIND="$2"
+            shift 2
+            ;;
+        --help|-h)
+            usage
+            exit 0
+            ;;
+        -*)
+            echo "Unknown option: $1"
+            usage
+            exit 1
+            ;;
+        *)
+            MODULE_NAME="$1"
+            shift
+            ;;
+    esac
+done
+
+if [ -z "$MODULE_NAME" ]; then
     usage
     exit 1
 fi
 
-MODULE_NAME="$1"
 MODULE_DIR="$MODULES_DIR/$MODULE_NAME"
 
+if [ -n "$KIND" ]; then
+    KIND_DIR="$TEMPLATE_DIR/kinds/$KIND"
+    if [ ! -d "$KIND_DIR" ]; then
+        echo -e "${RED}Error: Unknown kind '$KIND'${NC}"
+        echo "Available: $(ls "$TEMPLATE_DIR/kinds" | tr '\n' ' ')"
+        exit 1
+    fi
+    SOURCE="$KIND_DIR/template.c"
+else
+    SOURCE="$TEMPLATE_DIR/template.c"
+fi
+
 # Validate module name (alphanumeric and underscore only)
 if [[ ! "$MODULE_NAME" =~ ^[a-zA-Z_][a-zA-Z0-9_]*$ ]]; then
     echo -e "${RED}Error: Invalid module name '$MODULE_NAME'${NC}"
@@ -54,25 +105,39 @@ if [ -d "$MODULE_DIR" ]; then
 fi
 
 # Create module directory
-echo ">>> Creating module: $MODULE_NAME"
+echo ">>> Creating module: $MODULE_NAME${KIND:+ ($KIND)}"
 mkdir -p "$MODULE_DIR"
 
 # Copy and customize Makefile
 cp "$TEMPLATE_DIR/Makefile" "$MODULE_DIR/"
 
+# fill_template <file> - substitute the module name for the template token
+fill_template() {
+    sed -e "s/template/$MODULE_NAME/g" \
+        -e "s/Template/${MODULE_NAME^}/g" \
+        -e "s/TEMPLATE/${MODULE_NAME^^}/g" \
+        "$1"
+}
+
 # Copy and rename template.c
-sed -e "s/template/$MODULE_NAME/g" \
-    -e "s/Template/${MODULE_NAME^}/g" \
-    -e "s/TEMPLATE/${MODULE_NAME^^}/g" \
-    "$TEMPLATE_DIR/template.c" > "$MODULE_DIR/$MODULE_NAME.c"
+fill_template "$SOURCE" > "$MODULE_DIR/$MODULE_NAME.c"
+
+# Benchmark workload for scripts/test-module.sh
+if [ -n "$KIND" ]; then
+    fill_template "$KIND_DIR/workload.sh" > "$MODULE_DIR/workload.sh"
+    chmod +x "$MODULE_DIR/workload.sh"
+fi
 
 echo -e "${GREEN}>>> Module created: $MODULE_DIR${NC}"
 echo ""
 echo "Files:"
 echo "  $MODULE_DIR/Makefile"
 echo "  $MODULE_DIR/$MODULE_NAME.c"
+[ -n "$KIND" ] && echo "  $MODULE_DIR/workload.sh"
 echo ""
 echo "Next steps:"
 echo "  1. Edit $MODULE_DIR/$MODULE_NAME.c"
 echo "  2. Build: make modules"
 echo "  3. Or build just this module: cd modules/$MODULE_NAME && make"
+[ -n "$KIND" ] && echo "  4. Benchmark: make test MODULE=$MODULE_NAME"
+exit 0
@@ -0,0 +1,165 @@
+#!/usr/bin/env python3
+"""
+profile-report.py - Summarize symcount TCG plugin output
+
+Reads the profile.txt written by tools/tcg-plugin/libsymcount.so and
+prints, per phase:
+
+  - guest instructions (kernel / user)
+  - tracked functions: calls, inclusive instructions, instructions per call
+    and per call of the --per function (e.g. per openat), with the delta
+    against the 'baseline' phase
+  - the hottest kernel symbols, built by attributing each translation block
+    to the symbol containing its start address
+
+Symbol files are 'nm -n' style: "<hex addr> <type> <name>" per line.
+
+Usage:
+  profile-report.py --syms vmlinux.syms [--syms mod.syms ...]
+                    [--per __arm64_sys_openat] [--top 15] profile.txt
+"""
+
+import argparse
+import bisect
+import collections
+import sys
+
+# Setup phases that only exist to move between measured phases
+SETUP_PREFIXES = ("boot", "load-", "unload-", "end")
+
+
+class SymbolTable:
+    def __init__(self):
+        self.addrs = []
+        self.names = []
+
+    def load(self, path):
+        entries = []
+        with open(path) as f:
+            for line in f:
+                parts = line.split()
+                if len(parts) < 3 or parts[1] not in "tTwW":
+                    continue
+                entries.append((int(parts[0], 16), parts[2]))
+        merged = sorted(list(zip(self.addrs, self.names)) + entries)
+        self.addrs = [a for a, _ in merged]
+        self.names = [n for _, n in merged]
+
+    def lookup(self, addr):
+        i = bisect.bisect_right(self.addrs, addr) - 1
+        if i < 0:
+            return "[unknown]"
+        return self.names[i]
+
+
+class Phase:
+    def __init__(self, name):
+        self.name = name
+        self.kernel = 0
+        self.user = 0
+        self.tracks = collections.OrderedDict()  # name -> (calls, insns)
+        self.tbs = []  # (vaddr, n_insns, execs)
+
+
+def parse(path):
+    phases = collections.OrderedDict()
+
+    def phase(name):
+        if name not in phases:
+            phases[name] = Phase(name)
+        return phases[name]
+
+    with open(path) as f:
+        for line in f:
+            parts = line.split()
+            if not parts or parts[0] == "#":
+                continue
+            if parts[0] == "insns":
+                p = phase(parts[1])
+                p.kernel, p.user = int(parts[3]), int(parts[5])
+            elif parts[0] == "track":
+                p = phase(parts[1])
+                p.tracks[parts[2]] = (int(parts[5]), int(parts[7]))
+            elif parts[0] == "tb":
+                p = phase(parts[1])
+                p.tbs.append((int(parts[2], 16), int(parts[3]), int(parts[4])))
+    return phases
+
+
+def per_call(calls, insns):
+    return insns / calls if calls else 0.0
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Summarize symcount output")
+    ap.add_argument("profile")
+    ap.add_argument("--syms", action="append", default=[],
+                    help="nm -n style symbol file (repeatable)")
+    ap.add_argument("--per", default="__arm64_sys_openat",
+                    help="tracked function that defines one operation")
+    ap.add_argument("--top", type=int, default=15,
+                    help="hot symbols shown per phase")
+    ap.add_argument("--all-phases", action="store_true",
+                    help="include boot/load/unload phases")
+    args = ap.parse_args()
+
+    syms = SymbolTable()
+    for path in args.syms:
+        syms.load(path)
+
+    phases = parse(args.profile)
+    shown = [p for p in phases.values()
+             if args.all_phases or not p.name.startswith(SETUP_PREFIXES)]
+    if not shown:
+        sys.exit("profile-report: no measured phases in " + args.profile)
+
+    base = phases.get("baseline")
+    base_per = per_call(*base.tracks.get(args.per, (0, 0))) if base else None
+
+    print("=" * 78)
+    print("  Instructions per %s (inclusive)" % args.per)
+    print("=" * 78)
+    print("  %-24s %10s %14s %14s" % ("phase", "calls", "insns/call",
+                                      "vs baseline"))
+    for p in shown:
+        calls, insns = p.tracks.get(args.per, (0, 0))
+        value = per_call(calls, insns)
+        delta = ("%+14.1f" % (value - base_per)
+                 if base_per is not None and p is not base else "%14s" % "-")
+        print("  %-24s %10d %14.1f %s" % (p.name, calls, value, delta))
+
+    for p in shown:
+        ops = p.tracks.get(args.per, (0, 0))[0]
+
+        print("")
+        print("=" * 78)
+        print("  Phase: %s" % p.name)
+        print("=" * 78)
+        print("  Guest instructions: kernel %d, user %d" % (p.kernel, p.user))
+
+        print("")
+        print("  %-32s %9s %14s %11s %11s" % ("tracked function", "calls",
+                                              "insns", "insns/call",
+                                              "per op"))
+        for name, (calls, insns) in p.tracks.items():
+            print("  %-32s %9d %14d %11.1f %11.1f" % (
+                name[:32], calls, insns, per_call(calls, insns),
+                per_call(ops, insns)))
+
+        hot = collections.defaultdict(lambda: [0, 0])
+        for vaddr, n_insns, execs in p.tbs:
+            entry = hot[syms.lookup(vaddr)]
+            entry[0] += n_insns * execs
+            entry[1] += 1
+
+        print("")
+        print("  %-40s %14s %7s %6s" % ("hot kernel symbol", "insns",
+                                         "%kern", "TBs"))
+        ranked = sorted(hot.items(), key=lambda kv: kv[1][0], reverse=True)
+        for name, (insns, ntbs) in ranked[:args.top]:
+            share = 100.0 * insns / p.kernel if p.kernel else 0.0
+            print("  %-40s %14d %6.1f%% %6d" % (name[:40], insns, share, ntbs))
+
+
+if __name__ == "__main__":
+    main()
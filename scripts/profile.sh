@@ -0,0 +1,277 @@
+#!/bin/bash
+
+# ==============================================================================
+# AArch64 Lab - Instruction-Count Overhead Profiler
+# ==============================================================================
+# Boots a headless VM under the symcount TCG plugin and measures exactly how
+# many guest instructions each tracer module adds per openat.
+#
+# Phases (each with its own counters):
+#   baseline        OPENS opens of /etc/hostname, no module loaded
+#   <module>        same workload with <module> loaded
+#
+# In every phase __arm64_sys_openat and do_sys_openat2 are tracked
+# inclusively (entry to return, including callees and the kprobe/ftrace
+# machinery patched into them); in module phases every function in the
+# module's .text is tracked too (or only the ones named with --track).
+# The plugin tracks at most MAX_TRACK functions per phase
+# (tools/tcg-plugin/symcount.c); a module with more functions than fit next
+# to the kernel ones is rejected rather than silently cut short.
+#
+# The phases are switched from inside the guest by a single process that
+# also runs the loop (scripts/guest/profile-phases.sh), so no SSH login or
+# host-side poke lands in a measured phase.
+#
+# Usage:
+#   ./scripts/profile.sh [OPTIONS] [module...]
+# ==============================================================================
+
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+LAB_ROOT="$(dirname "$SCRIPT_DIR")"
+GOLDEN_IMAGE="$LAB_ROOT/debian-rootfs.qcow2"
+MODULES_DIR="$LAB_ROOT/modules"
+VMS_DIR="$LAB_ROOT/vms"
+VMLINUX="$LAB_ROOT/linux-6.6/vmlinux"
+PLUGIN_SRC="$LAB_ROOT/tools/tcg-plugin/symcount.c"
+CROSS_COMPILE="${CROSS_COMPILE:-aarch64-linux-gnu-}"
+
+# shellcheck source=vm-lib.sh
+source "$SCRIPT_DIR/vm-lib.sh"
+
+# Colors
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+NC='\033[0m' # No Color
+
+# Defaults
+CPUS="1"
+MEMORY="2G"
+SSH_PORT="${PROFILE_SSH_PORT:-10091}"
+OPENS="2000"
+BOOT_TIMEOUT="600"
+OUT_DIR=""
+TRACK=""
+
+# Kernel functions tracked in every phase
+KERNEL_TRACK="__arm64_sys_openat do_sys_openat2"
+
+# Tracked functions per phase, from the plugin source so the two can't drift
+MAX_TRACK="$(awk '$1 == "#define" && $2 == "MAX_TRACK" { print $3 }' "$PLUGIN_SRC")"
+MODULE_TRACK_MAX=$(( MAX_TRACK - $(wc -w <<< "$KERNEL_TRACK") ))
+
+usage() {
+    echo "Usage: $0 [OPTIONS] [module...]"
+    echo ""
+    echo "Options:"
+    echo "  --opens N      Opens per phase (default: $OPENS)"
+    echo "  --cpus N       vCPUs (default: $CPUS; 1 gives the most stable counts)"
+    echo "  --mem SIZE     Memory (default: $MEMORY)"
+    echo "  --track FUNCS  Module functions to track, comma-separated"
+    echo "                 (default: all of .text, at most $MODULE_TRACK_MAX)"
+    echo "  --out DIR      Results directory (default: results/profile-<time>)"
+    echo ""
+    echo "Default modules: trace_openat trace_openat_ftrace"
+    echo ""
+    echo "Examples:"
+    echo "  $0"
+    echo "  $0 --opens 10000 trace_openat_ftrace"
+    echo "  $0 --track trace_openat_handler trace_openat"
+}
+
+# --- Parse Arguments ---
+PROFILE_MODULES=()
+while [[ $# -gt 0 ]]; do
+    case "$1" in
+        --opens)
+            OPENS="$2"
+            shift 2
+            ;;
+        --cpus)
+            CPUS="$2"
+            shift 2
+            ;;
+        --mem)
+            MEMORY="$2"
+            shift 2
+            ;;
+        --out)
+            OUT_DIR="$2"
+            shift 2
+            ;;
+        --track)
+            TRACK="${2//,/ }"
+            shift 2
+            ;;
+        --help|-h)
+            usage
+            exit 0
+            ;;
+        -*)
+            echo "Unknown option: $1"
+            echo "Use --help for usage information."
+            exit 1
+            ;;
+        *)
+            PROFILE_MODULES+=("$1")
+            shift
+            ;;
+    esac
+done
+
+if [ ${#PROFILE_MODULES[@]} -eq 0 ]; then
+    PROFILE_MODULES=(trace_openat trace_openat_ftrace)
+fi
+
+for f in "$GOLDEN_IMAGE" "$VMLINUX"; do
+    if [ ! -f "$f" ]; then
+        echo -e "${RED}Error: $f not found. Run 'make kernel' and 'make rootfs' first.${NC}"
+        exit 1
+    fi
+done
+
+vm_require_tools
+
+OUT_DIR="${OUT_DIR:-$LAB_ROOT/results/profile-$(date +%Y%m%d-%H%M%S)}"
+OUT_DIR="$(realpath -m "$OUT_DIR")"
+mkdir -p "$OUT_DIR"
+
+# --- Build ---
+echo ">>> Building plugin and modules..."
+make -C "$LAB_ROOT/tools/tcg-plugin" > "$OUT_DIR/build.log" 2>&1 || {
+    echo -e "${RED}>>> Plugin build failed (see $OUT_DIR/build.log)${NC}"
+    exit 1
+}
+for m in "${PROFILE_MODULES[@]}"; do
+    make -C "$MODULES_DIR/$m" >> "$OUT_DIR/build.log" 2>&1 || {
+        echo -e "${RED}>>> Build of $m failed (see $OUT_DIR/build.log)${NC}"
+        exit 1
+    }
+done
+
+# module_functions <module> [names] - "offset name" for each .text
+# function, or only those in the space-separated names
+module_functions() {
+    "${CROSS_COMPILE}objdump" -t "$MODULES_DIR/$1/bin/$1.ko" |
+        awk -v want="$2" '
+            BEGIN { n = split(want, w, " "); for (i = 1; i <= n; i++) keep[w[i]] = 1 }
+            $3 == "F" && $4 == ".text" && (n == 0 || $6 in keep) { print $1, $6 }'
+}
+
+# Every tracked function must fit in the plugin's table
+for m in "${PROFILE_MODULES[@]}"; do
+    n="$(module_functions "$m" "$TRACK" | wc -l)"
+    if [ "$n" -gt "$MODULE_TRACK_MAX" ]; then
+        echo -e "${RED}Error: $m has $n functions to track, the plugin takes $MODULE_TRACK_MAX${NC}"
+        echo "(MAX_TRACK=$MAX_TRACK in $PLUGIN_SRC, minus the kernel functions)."
+        echo "Pick the ones you want with --track, e.g.:"
+        echo "  $0 --track $(module_functions "$m" "$TRACK" | awk 'NR <= 2 { printf "%s%s", sep, $2; sep = "," }') $m"
+        exit 1
+    fi
+    if [ "$n" -eq 0 ] && [ -n "$TRACK" ]; then
+        echo -e "${YELLOW}Warning: none of the --track functions are in $m's .text${NC}"
+    fi
+done
+
+# --- Symbols ---
+# vmlinux.syms: "addr type name" sorted by address, used for the report
+"${CROSS_COMPILE}nm" -n "$VMLINUX" > "$OUT_DIR/vmlinux.syms"
+
+KERNEL_TRACK_LINES=""
+for sym in $KERNEL_TRACK; do
+    addr="$(awk -v s="$sym" '$3 == s { print $1; exit }' "$OUT_DIR/vmlinux.syms")"
+    if [ -z "$addr" ]; then
+        echo -e "${RED}Error: $sym not found in vmlinux${NC}"
+        exit 1
+    fi
+    KERNEL_TRACK_LINES+="track $sym $addr"$'\n'
+done
+
+# guest <command> - run in the guest, stdin detached
+guest() {
+    vm_ssh "$SSH_PORT" "$@" < /dev/null
+}
+
+# --- Instance ---
+# The plugin's control file and output live in the shared folder, where
+# the guest side (scripts/guest/profile-phases.sh) drives the phases
+INST="$(vm_instance_dir "$VMS_DIR" profile)"
+PROF_DIR="$INST/shared/profile"
+SSH_PORT="$(vm_find_port "$SSH_PORT")" || exit 1
+mkdir -p "$INST/shared/modules" "$PROF_DIR"
+cp "$SCRIPT_DIR/guest/profile-phases.sh" "$INST/shared/"
+printf '%s' "$KERNEL_TRACK_LINES" > "$PROF_DIR/kernel.track"
+for m in "${PROFILE_MODULES[@]}"; do
+    cp "$MODULES_DIR/$m/bin/$m.ko" "$INST/shared/modules/"
+    module_functions "$m" "$TRACK" > "$PROF_DIR/$m.funcs"
+done
+vm_create_overlay "$INST/disk.qcow2" "$GOLDEN_IMAGE"
+
+QEMU_PID=""
+cleanup() {
+    if [ -n "$QEMU_PID" ]; then
+        vm_stop "$QEMU_PID" "$INST/qmp.sock"
+    fi
+    rm -rf "$INST"
+}
+trap cleanup EXIT
+
+printf 'phase boot\n%s' "$KERNEL_TRACK_LINES" > "$PROF_DIR/ctl"
+: > "$PROF_DIR/profile.txt"
+
+"$SCRIPT_DIR/start.sh" \
+    --no-debug \
+    --profile "$PROF_DIR" \
+    --image "$INST/disk.qcow2" \
+    --share-dir "$INST/shared" \
+    --ssh-port "$SSH_PORT" \
+    --qmp "$INST/qmp.sock" \
+    --serial-log "$OUT_DIR/serial.log" \
+    --cpus "$CPUS" \
+    --mem "$MEMORY" \
+    > "$OUT_DIR/start.log" 2>&1 < /dev/null &
+QEMU_PID=$!
+
+echo ">>> Booting VM under the profiling plugin (this is slower than usual)..."
+if ! vm_wait_ssh "$SSH_PORT" "$QEMU_PID" "$BOOT_TIMEOUT"; then
+    echo -e "${RED}>>> VM did not come up (see $OUT_DIR/serial.log)${NC}"
+    exit 1
+fi
+
+guest "mount-shared > /dev/null && dmesg -n 1"
+
+# One guest process runs every phase; see scripts/guest/profile-phases.sh
+if ! guest "bash $VM_SHARE_MOUNT/profile-phases.sh $VM_SHARE_MOUNT/profile $OPENS ${PROFILE_MODULES[*]}"; then
+    echo -e "${RED}>>> Profiling run failed in the guest${NC}"
+    exit 1
+fi
+
+# Stop QEMU now so the plugin writes the final phase
+vm_stop "$QEMU_PID" "$INST/qmp.sock"
+QEMU_PID=""
+
+cp "$PROF_DIR/ctl" "$PROF_DIR/profile.txt" "$OUT_DIR/"
+
+# <module>.syms: every .text function at its guest address, for the report
+for m in "${PROFILE_MODULES[@]}"; do
+    base="$(< "$PROF_DIR/$m.base")"
+    module_functions "$m" |
+        while read -r off name; do
+            # 64-bit wraparound in bash arithmetic still prints correctly
+            printf '%016x t %s\n' $(( base + 0x$off )) "$name"
+        done > "$OUT_DIR/$m.syms"
+done
+
+# --- Report ---
+SYM_ARGS=(--syms "$OUT_DIR/vmlinux.syms")
+for m in "${PROFILE_MODULES[@]}"; do
+    SYM_ARGS+=(--syms "$OUT_DIR/$m.syms")
+done
+
+python3 "$SCRIPT_DIR/profile-report.py" "${SYM_ARGS[@]}" \
+    --per __arm64_sys_openat "$OUT_DIR/profile.txt" | tee "$OUT_DIR/report.txt"
+
+echo ""
+echo -e "${GREEN}>>> Profile written to $OUT_DIR${NC}"
@@ -0,0 +1,247 @@
+#!/bin/bash
+
+# ==============================================================================
+# AArch64 Lab - SMP Scaling Sweep
+# ==============================================================================
+# Runs tools/openat_stress (one pinned thread per vCPU) at several vCPU
+# counts, with no tracer and with each tracer module loaded, and tabulates
+# throughput. A tracer whose shared state contends across CPUs shows up as
+# per-thread throughput falling as vCPUs are added.
+#
+# One VM is booted per vCPU count; modules are loaded and unloaded in turn
+# inside it.
+#
+# Usage:
+#   ./scripts/smp-sweep.sh [OPTIONS]
+# ==============================================================================
+
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+LAB_ROOT="$(dirname "$SCRIPT_DIR")"
+GOLDEN_IMAGE="$LAB_ROOT/debian-rootfs.qcow2"
+MODULES_DIR="$LAB_ROOT/modules"
+STRESS_DIR="$LAB_ROOT/tools/openat_stress"
+VMS_DIR="$LAB_ROOT/vms"
+
+# shellcheck source=vm-lib.sh
+source "$SCRIPT_DIR/vm-lib.sh"
+
+# Colors
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+NC='\033[0m' # No Color
+
+# Defaults
+CPU_LIST="1 2 4 8"
+SWEEP_MODULES="none trace_openat trace_openat_ftrace"
+DURATION="10"
+RATE="0"
+PATHS="/etc/hostname"
+PARAMS=""
+MEMORY="2G"
+SWEEP_PORT="${SWEEP_SSH_PORT:-10092}"
+SSH_PORT=""
+BOOT_TIMEOUT="300"
+OUT_DIR=""
+
+usage() {
+    echo "Usage: $0 [OPTIONS]"
+    echo ""
+    echo "Options:"
+    echo "  --cpus-list \"N...\"   vCPU counts (default: \"$CPU_LIST\")"
+    echo "  --modules \"M...\"     Tracers, 'none' = no module (default: \"$SWEEP_MODULES\")"
+    echo "  --duration S         Seconds per run (default: $DURATION)"
+    echo "  --rate R             Per-thread opens/s, 0 = unlimited (default: $RATE)"
+    echo "  --paths LIST         Comma-separated guest paths (default: $PATHS)"
+    echo "  --params \"k=v\"       Parameters for every insmod"
+    echo "  --mem SIZE           Memory (default: $MEMORY)"
+    echo "  --out DIR            Results directory (default: results/sweep-<time>)"
+    echo ""
+    echo "Examples:"
+    echo "  $0"
+    echo "  $0 --cpus-list \"1 2 4\" --modules \"none trace_openat_ftrace\" --duration 5"
+}
+
+# --- Parse Arguments ---
+while [[ $# -gt 0 ]]; do
+    case "$1" in
+        --cpus-list)
+            CPU_LIST="$2"
+            shift 2
+            ;;
+        --modules)
+            SWEEP_MODULES="$2"
+            shift 2
+            ;;
+        --duration)
+            DURATION="$2"
+            shift 2
+            ;;
+        --rate)
+            RATE="$2"
+            shift 2
+            ;;
+        --paths)
+            PATHS="$2"
+            shift 2
+            ;;
+        --params)
+            PARAMS="$2"
+            shift 2
+            ;;
+        --mem)
+            MEMORY="$2"
+            shift 2
+            ;;
+        --out)
+            OUT_DIR="$2"
+            shift 2
+            ;;
+        --help|-h)
+            usage
+            exit 0
+            ;;
+        *)
+            echo "Unknown option: $1"
+            echo "Use --help for usage information."
+            exit 1
+            ;;
+    esac
+done
+
+if [ ! -f "$GOLDEN_IMAGE" ]; then
+    echo -e "${RED}Error: Golden image not found: $GOLDEN_IMAGE${NC}"
+    echo "Run 'sudo ./setup/setup_debian.sh' first."
+    exit 1
+fi
+
+vm_require_tools
+
+OUT_DIR="${OUT_DIR:-$LAB_ROOT/results/sweep-$(date +%Y%m%d-%H%M%S)}"
+mkdir -p "$OUT_DIR"
+
+# --- Build ---
+echo ">>> Building openat_stress and modules..."
+make -C "$STRESS_DIR" > "$OUT_DIR/build.log" 2>&1 || {
+    echo -e "${RED}>>> openat_stress build failed (see $OUT_DIR/build.log)${NC}"
+    exit 1
+}
+for m in $SWEEP_MODULES; do
+    [ "$m" = "none" ] && continue
+    make -C "$MODULES_DIR/$m" >> "$OUT_DIR/build.log" 2>&1 || {
+        echo -e "${RED}>>> Build of $m failed (see $OUT_DIR/build.log)${NC}"
+        exit 1
+    }
+done
+
+# --- Instance ---
+INST="$(vm_instance_dir "$VMS_DIR" sweep)"
+mkdir -p "$INST/shared/modules" "$INST/shared/tools"
+cp "$STRESS_DIR/bin/openat_stress" "$INST/shared/tools/"
+for m in $SWEEP_MODULES; do
+    [ "$m" = "none" ] && continue
+    cp "$MODULES_DIR/$m/bin/$m.ko" "$INST/shared/modules/"
+done
+
+QEMU_PID=""
+cleanup() {
+    if [ -n "$QEMU_PID" ]; then
+        vm_stop "$QEMU_PID" "$INST/qmp.sock"
+    fi
+    rm -rf "$INST"
+}
+trap cleanup EXIT
+
+# guest <command> - run in the guest, stdin detached
+guest() {
+    vm_ssh "$SSH_PORT" "$@" < /dev/null
+}
+
+printf 'cpus\tmodule\tops_per_sec\tops_per_sec_per_thread\terrors\n' > "$OUT_DIR/summary.tsv"
+
+for cpus in $CPU_LIST; do
+    if [ "$cpus" -gt "$(nproc)" ]; then
+        echo ">>> Note: $cpus vCPUs on $(nproc) host CPUs - results will be host-bound"
+    fi
+
+    # Each boot takes the first free port from the configured one
+    SSH_PORT="$(vm_find_port "$SWEEP_PORT")" || exit 1
+    vm_create_overlay "$INST/disk.qcow2" "$GOLDEN_IMAGE"
+    "$SCRIPT_DIR/start.sh" \
+        --no-debug \
+        --image "$INST/disk.qcow2" \
+        --share-dir "$INST/shared" \
+        --ssh-port "$SSH_PORT" \
+        --qmp "$INST/qmp.sock" \
+        --serial-log "$OUT_DIR/serial-cpus$cpus.log" \
+        --cpus "$cpus" \
+        --mem "$MEMORY" \
+        > "$INST/start.log" 2>&1 < /dev/null &
+    QEMU_PID=$!
+
+    echo ">>> Booting VM with $cpus vCPU(s) (ssh port $SSH_PORT)..."
+    if ! vm_wait_ssh "$SSH_PORT" "$QEMU_PID" "$BOOT_TIMEOUT"; then
+        echo -e "${RED}>>> VM did not come up (see $OUT_DIR/serial-cpus$cpus.log)${NC}"
+        exit 1
+    fi
+    guest "mount-shared > /dev/null && dmesg -n 1"
+
+    for m in $SWEEP_MODULES; do
+        run="$OUT_DIR/cpus$cpus-$m.txt"
+
+        if [ "$m" != "none" ]; then
+            guest "insmod $VM_SHARE_MOUNT/modules/$m.ko $PARAMS"
+        fi
+
+        guest "$VM_SHARE_MOUNT/tools/openat_stress -t $cpus -d $DURATION -r $RATE -p $PATHS" > "$run"
+
+        if [ "$m" != "none" ]; then
+            guest "rmmod $m"
+        fi
+
+        total="$(grep '^total ' "$run")"
+        ops=$(sed -n 's/.* ops_per_sec=\([0-9.]*\).*/\1/p' <<< "$total")
+        per=$(sed -n 's/.*ops_per_sec_per_thread=\([0-9.]*\).*/\1/p' <<< "$total")
+        errs=$(sed -n 's/.* errors=\([0-9]*\).*/\1/p' <<< "$total")
+        printf '%s\t%s\t%s\t%s\t%s\n' "$cpus" "$m" "$ops" "$per" "$errs" \
+            >> "$OUT_DIR/summary.tsv"
+        printf '    cpus=%-3s %-24s %12s ops/s  (%s per thread)\n' "$cpus" "$m" "$ops" "$per"
+    done
+
+    guest "dmesg" > "$OUT_DIR/dmesg-cpus$cpus.log" 2>&1 || true
+    vm_stop "$QEMU_PID" "$INST/qmp.sock"
+    QEMU_PID=""
+done
+
+# --- Summary ---
+# Per-thread throughput relative to the 1st vCPU count: 1.00 = perfect
+# scaling, lower = the extra CPUs are waiting on each other.
+echo ""
+echo "=============================================================================="
+echo "  Per-thread opens/s (scaling vs. first vCPU count)"
+echo "=============================================================================="
+awk -F'\t' -v cpus_list="$CPU_LIST" '
+NR == 1 { next }
+{
+    per[$2, $1] = $4
+    if (!($2 in seen)) { seen[$2] = 1; order[++nm] = $2 }
+}
+END {
+    nc = split(cpus_list, cl, " ")
+    printf "  %-24s", "module"
+    for (c = 1; c <= nc; c++) printf " %16s", cl[c] " vCPU"
+    printf "\n"
+    for (i = 1; i <= nm; i++) {
+        m = order[i]
+        base = per[m, cl[1]]
+        printf "  %-24s", m
+        for (c = 1; c <= nc; c++) {
+            v = per[m, cl[c]]
+            printf " %9.0f (%4.2f)", v, (base > 0 ? v / base : 0)
+        }
+        printf "\n"
+    }
+}' "$OUT_DIR/summary.tsv" | tee "$OUT_DIR/summary.txt"
+echo ""
+echo -e "${GREEN}>>> Results in $OUT_DIR${NC}"
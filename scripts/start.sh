@@ -15,6 +15,19 @@
 #   --mem SIZE   Set memory size (default: 2G)
 #   --cpus N     Set CPU count (default: 2)
 #   --help       Show this help
+#
+# Instance options (used by multi-run.sh to run several VMs side by side):
+#   --image PATH        Runtime image (created from golden image if missing)
+#   --share-dir DIR     Shared folder to export (implies --shared)
+#   --ssh-port N        Host port forwarded to guest SSH (default: 10022)
+#   --gdb-port N        GDB server port (default: 1234)
+#   --gdb-nowait        Start GDB server but don't pause at startup
+#   --qmp PATH          Expose a QMP control socket at PATH
+#   --serial-log FILE   Headless: write serial console to FILE
+#
+# Profiling (see scripts/profile.sh):
+#   --profile DIR       Load the symcount TCG plugin; control file DIR/ctl,
+#                       counts written to DIR/profile.txt
 # ==============================================================================
 
 set -e
@@ -27,12 +40,19 @@ KERNEL="$LAB_ROOT/linux-6.6/arch/arm64/boot/Image"
 RUNTIME_IMAGE="$LAB_ROOT/debian-runtime.qcow2"
 GOLDEN_IMAGE="$LAB_ROOT/debian-rootfs.qcow2"
 SHARE_DIR="$LAB_ROOT/shared"
+PROFILE_PLUGIN="$LAB_ROOT/tools/tcg-plugin/libsymcount.so"
 
 # Defaults
 MEMORY="2G"
 CPUS="2"
 SHARED=0
 DEBUG=1  # Default: debug enabled
+GDB_WAIT=1
+SSH_PORT="10022"
+GDB_PORT="1234"
+QMP_SOCKET=""
+SERIAL_LOG=""
+PROFILE_DIR=""
 
 # --- Parse Arguments ---
 while [[ $# -gt 0 ]]; do
@@ -57,6 +77,40 @@ while [[ $# -gt 0 ]]; do
             CPUS="$2"
             shift 2
             ;;
+        --image)
+            RUNTIME_IMAGE="$2"
+            shift 2
+            ;;
+        --share-dir)
+            SHARE_DIR="$2"
+            SHARED=1
+            shift 2
+            ;;
+        --ssh-port)
+            SSH_PORT="$2"
+            shift 2
+            ;;
+        --gdb-port)
+            GDB_PORT="$2"
+            shift 2
+            ;;
+        --gdb-nowait)
+            DEBUG=1
+            GDB_WAIT=0
+            shift
+            ;;
+        --qmp)
+            QMP_SOCKET="$2"
+            shift 2
+            ;;
+        --serial-log)
+            SERIAL_LOG="$2"
+            shift 2
+            ;;
+        --profile)
+            PROFILE_DIR="$2"
+            shift 2
+            ;;
         --help|-h)
             echo "Usage: $0 [OPTIONS]"
             echo ""
@@ -67,6 +121,16 @@ while [[ $# -gt 0 ]]; do
             echo "  --mem SIZE   Memory size (default: 2G)"
             echo "  --cpus N     CPU count (default: 2)"
             echo ""
+            echo "Instance options:"
+            echo "  --image PATH        Runtime image (default: debian-runtime.qcow2)"
+            echo "  --share-dir DIR     Shared folder to export (implies --shared)"
+            echo "  --ssh-port N        Host port for guest SSH (default: 10022)"
+            echo "  --gdb-port N        GDB server port (default: 1234)"
+            echo "  --gdb-nowait        Start GDB server without pausing"
+            echo "  --qmp PATH          QMP control socket"
+            echo "  --serial-log FILE   Headless: serial console to FILE"
+            echo "  --profile DIR       Instruction-count profiling (TCG plugin)"
+            echo ""
             echo "Examples:"
             echo "  $0                    # Basic debug mode"
             echo "  $0 --shared           # With shared folder"
@@ -89,6 +153,12 @@ if [ ! -f "$KERNEL" ]; then
     exit 1
 fi
 
+if [ -n "$PROFILE_DIR" ] && [ ! -f "$PROFILE_PLUGIN" ]; then
+    echo "Error: Profiling plugin not found at $PROFILE_PLUGIN"
+    echo "Run 'make -C tools/tcg-plugin' first."
+    exit 1
+fi
+
 # Auto-create runtime image if missing
 if [ ! -f "$RUNTIME_IMAGE" ]; then
     if [ ! -f "$GOLDEN_IMAGE" ]; then
@@ -97,7 +167,10 @@ if [ ! -f "$RUNTIME_IMAGE" ]; then
         exit 1
     fi
     echo ">>> Creating runtime image from golden image..."
-    qemu-img create -f qcow2 -F qcow2 -b "$(basename "$GOLDEN_IMAGE")" "$RUNTIME_IMAGE" > /dev/null
+    mkdir -p "$(dirname "$RUNTIME_IMAGE")"
+    # Backing path is relative to the overlay, so images can live anywhere
+    BACKING="$(realpath --relative-to="$(dirname "$RUNTIME_IMAGE")" "$GOLDEN_IMAGE")"
+    qemu-img create -f qcow2 -F qcow2 -b "$BACKING" "$RUNTIME_IMAGE" > /dev/null
 fi
 
 # --- Build QEMU Command ---
@@ -106,15 +179,26 @@ QEMU_ARGS=(
     -cpu cortex-a57
     -m "$MEMORY"
     -smp "$CPUS"
-    -nographic
     -kernel "$KERNEL"
     -drive "if=none,file=$RUNTIME_IMAGE,format=qcow2,id=hd0"
     -device "virtio-blk-device,drive=hd0"
     -append "root=/dev/vda rw console=ttyAMA0 nokaslr"
-    -netdev "user,id=net0,hostfwd=tcp::10022-:22"
+    -netdev "user,id=net0,hostfwd=tcp::$SSH_PORT-:22"
     -device "virtio-net-device,netdev=net0"
 )
 
+# Console: interactive on stdio, or headless with serial to a log file
+if [ -n "$SERIAL_LOG" ]; then
+    QEMU_ARGS+=(-display none -monitor none -serial "file:$SERIAL_LOG")
+else
+    QEMU_ARGS+=(-nographic)
+fi
+
+# QMP control socket (e.g. for scripted shutdown)
+if [ -n "$QMP_SOCKET" ]; then
+    QEMU_ARGS+=(-qmp "unix:$QMP_SOCKET,server,nowait")
+fi
+
 # Add shared folder if requested
 if [ "$SHARED" -eq 1 ]; then
     mkdir -p "$SHARE_DIR"
@@ -123,9 +207,22 @@ if [ "$SHARED" -eq 1 ]; then
     )
 fi
 
+# Instruction-count profiling: the plugin reads DIR/ctl and writes
+# DIR/profile.txt (see tools/tcg-plugin/symcount.c)
+if [ -n "$PROFILE_DIR" ]; then
+    mkdir -p "$PROFILE_DIR"
+    touch "$PROFILE_DIR/ctl"
+    QEMU_ARGS+=(
+        -plugin "$PROFILE_PLUGIN,ctl=$PROFILE_DIR/ctl,out=$PROFILE_DIR/profile.txt"
+    )
+fi
+
 # Add debug flags if requested
 if [ "$DEBUG" -eq 1 ]; then
-    QEMU_ARGS+=(-s -S)
+    QEMU_ARGS+=(-gdb "tcp::$GDB_PORT")
+    if [ "$GDB_WAIT" -eq 1 ]; then
+        QEMU_ARGS+=(-S)
+    fi
 fi
 
 # --- Print Info ---
@@ -139,7 +236,7 @@ echo "  Memory:     $MEMORY"
 echo "  CPUs:       $CPUS"
 echo ""
 echo "  Login:      root / root"
-echo "  SSH:        ssh -p 10022 root@localhost"
+echo "  SSH:        ssh -p $SSH_PORT root@localhost"
 
 if [ "$SHARED" -eq 1 ]; then
     echo "  Shared:     $SHARE_DIR -> /mnt (run 'mount-shared' in guest)"
@@ -147,12 +244,26 @@ fi
 
 if [ "$DEBUG" -eq 1 ]; then
     echo ""
-    echo "  GDB:        Waiting for debugger on port 1234"
-    echo "              Run './debug.sh' in another terminal"
+    if [ "$GDB_WAIT" -eq 1 ]; then
+        echo "  GDB:        Waiting for debugger on port $GDB_PORT"
+        echo "              Run './debug.sh' in another terminal"
+    else
+        echo "  GDB:        Server on port $GDB_PORT (not paused)"
+    fi
 fi
 
-echo ""
-echo "  Exit QEMU:  Ctrl-a x"
+if [ -n "$SERIAL_LOG" ]; then
+    echo "  Serial:     $SERIAL_LOG"
+fi
+
+if [ -n "$PROFILE_DIR" ]; then
+    echo "  Profile:    $PROFILE_DIR/profile.txt (TCG plugin)"
+fi
+
+if [ -z "$SERIAL_LOG" ]; then
+    echo ""
+    echo "  Exit QEMU:  Ctrl-a x"
+fi
 echo "=============================================================================="
 echo ""
 
@@ -0,0 +1,340 @@
+#!/bin/bash
+
+# ==============================================================================
+# AArch64 Lab - Headless Module Test Harness
+# ==============================================================================
+# Boots a private VM (no GDB), loads a module, runs a workload, collects
+# dmesg / debugfs / benchmark output, unloads the module and checks the
+# kernel log after each step, and the serial console, for oopses.
+# Exits 0 on PASS, 1 on FAIL.
+#
+# Workload lookup (first match wins):
+#   --workload FILE
+#   modules/<name>/workload.sh
+#   scripts/guest/default-workload.sh
+#
+# The workload runs as root in the guest from /mnt/shared with:
+#   MODULE        Module name
+#   RESULTS_DIR   Guest directory for benchmark output (copied back)
+# plus every --env K=V and any *_ITERS variable set on the host.
+#
+# Usage:
+#   ./scripts/test-module.sh [OPTIONS] <module>
+# ==============================================================================
+
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+LAB_ROOT="$(dirname "$SCRIPT_DIR")"
+GOLDEN_IMAGE="$LAB_ROOT/debian-rootfs.qcow2"
+MODULES_DIR="$LAB_ROOT/modules"
+VMS_DIR="$LAB_ROOT/vms"
+
+# shellcheck source=vm-lib.sh
+source "$SCRIPT_DIR/vm-lib.sh"
+
+# Colors
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+YELLOW='\033[1;33m'
+NC='\033[0m' # No Color
+
+# Defaults
+CPUS="2"
+MEMORY="2G"
+SSH_PORT="${TEST_SSH_PORT:-10090}"
+BOOT_TIMEOUT="300"
+WORKLOAD_TIMEOUT="600"
+BUDGET=""
+PARAMS=""
+WORKLOAD=""
+OUT_DIR=""
+KEEP=0
+WORKLOAD_ENV=()
+
+# Kernel log patterns that fail a run
+OOPS_PATTERN='Oops|BUG:|WARNING:|Call trace:|Kernel panic|Unable to handle kernel|general protection fault|soft lockup|hung_task'
+
+usage() {
+    echo "Usage: $0 [OPTIONS] <module>"
+    echo ""
+    echo "Options:"
+    echo "  --workload FILE    Guest workload script (default: see header)"
+    echo "  --params \"k=v\"     Module parameters passed to insmod"
+    echo "  --env K=V          Extra workload environment (repeatable)"
+    echo "  --budget SECS      Fail if the workload takes longer than SECS"
+    echo "  --cpus N           vCPUs (default: $CPUS)"
+    echo "  --mem SIZE         Memory (default: $MEMORY)"
+    echo "  --out DIR          Results directory (default: results/test-<module>-<time>)"
+    echo "  --keep             Keep the VM instance directory afterwards"
+    echo ""
+    echo "Examples:"
+    echo "  $0 trace_openat_ftrace"
+    echo "  $0 --params target_pid=1 --budget 30 trace_openat"
+    echo "  $0 --env OPENAT_ITERS=20000 trace_openat_ftrace"
+}
+
+# --- Parse Arguments ---
+MODULE=""
+while [[ $# -gt 0 ]]; do
+    case "$1" in
+        --workload)
+            WORKLOAD="$(realpath "$2")"
+            shift 2
+            ;;
+        --params)
+            PARAMS="$2"
+            shift 2
+            ;;
+        --env)
+            if [[ "$2" != *=* ]]; then
+                echo "Error: --env takes K=V, got '$2'"
+                exit 1
+            fi
+            WORKLOAD_ENV+=("$2")
+            shift 2
+            ;;
+        --budget)
+            BUDGET="$2"
+            shift 2
+            ;;
+        --cpus)
+            CPUS="$2"
+            shift 2
+            ;;
+        --mem)
+            MEMORY="$2"
+            shift 2
+            ;;
+        --out)
+            OUT_DIR="$2"
+            shift 2
+            ;;
+        --keep)
+            KEEP=1
+            shift
+            ;;
+        --help|-h)
+            usage
+            exit 0
+            ;;
+        -*)
+            echo "Unknown option: $1"
+            echo "Use --help for usage information."
+            exit 1
+            ;;
+        *)
+            MODULE="$1"
+            shift
+            ;;
+    esac
+done
+
+if [ -z "$MODULE" ]; then
+    usage
+    exit 1
+fi
+
+if [ ! -d "$MODULES_DIR/$MODULE" ]; then
+    echo -e "${RED}Error: Module '$MODULE' not found in modules/${NC}"
+    exit 1
+fi
+
+if [ ! -f "$GOLDEN_IMAGE" ]; then
+    echo -e "${RED}Error: Golden image not found: $GOLDEN_IMAGE${NC}"
+    echo "Run 'sudo ./setup/setup_debian.sh' first."
+    exit 1
+fi
+
+if [ -z "$WORKLOAD" ]; then
+    if [ -f "$MODULES_DIR/$MODULE/workload.sh" ]; then
+        WORKLOAD="$MODULES_DIR/$MODULE/workload.sh"
+    else
+        WORKLOAD="$SCRIPT_DIR/guest/default-workload.sh"
+    fi
+fi
+
+vm_require_tools
+
+# Workload knobs set on the host (OPENAT_ITERS, CRED_ITERS, ...) go along;
+# --env comes last so it wins
+for var in $(compgen -v | grep '_ITERS$' || true); do
+    WORKLOAD_ENV=("$var=${!var}" "${WORKLOAD_ENV[@]}")
+done
+WORKLOAD_ENV_ARGS=""
+for kv in "${WORKLOAD_ENV[@]}"; do
+    WORKLOAD_ENV_ARGS+=" $(printf '%q' "$kv")"
+done
+
+OUT_DIR="${OUT_DIR:-$LAB_ROOT/results/test-$MODULE-$(date +%Y%m%d-%H%M%S)}"
+mkdir -p "$OUT_DIR"
+
+# now_ms - wall clock in milliseconds
+now_ms() {
+    echo $(( $(date +%s%N) / 1000000 ))
+}
+
+# --- Build ---
+echo ">>> Building $MODULE..."
+make -C "$MODULES_DIR/$MODULE" > "$OUT_DIR/build.log" 2>&1 || {
+    echo -e "${RED}>>> Build failed (see $OUT_DIR/build.log)${NC}"
+    exit 1
+}
+
+# --- Instance ---
+# A private directory and the first free port from $SSH_PORT, so test runs
+# can overlap with each other and with the other runners
+INST="$(vm_instance_dir "$VMS_DIR" "test-$MODULE")"
+SSH_PORT="$(vm_find_port "$SSH_PORT")" || exit 1
+mkdir -p "$INST/shared/modules" "$INST/shared/results"
+cp "$MODULES_DIR/$MODULE/bin/"* "$INST/shared/modules/"
+cp "$WORKLOAD" "$INST/shared/workload.sh"
+vm_create_overlay "$INST/disk.qcow2" "$GOLDEN_IMAGE"
+
+QEMU_PID=""
+cleanup() {
+    if [ -n "$QEMU_PID" ]; then
+        vm_stop "$QEMU_PID" "$INST/qmp.sock"
+    fi
+    cp "$INST/serial.log" "$OUT_DIR/serial.log" 2>/dev/null || true
+    if [ "$KEEP" -eq 0 ]; then
+        rm -rf "$INST"
+    else
+        echo "  Instance kept: $INST"
+    fi
+}
+trap cleanup EXIT
+
+T_START=$(now_ms)
+"$SCRIPT_DIR/start.sh" \
+    --no-debug \
+    --image "$INST/disk.qcow2" \
+    --share-dir "$INST/shared" \
+    --ssh-port "$SSH_PORT" \
+    --qmp "$INST/qmp.sock" \
+    --serial-log "$INST/serial.log" \
+    --cpus "$CPUS" \
+    --mem "$MEMORY" \
+    > "$INST/start.log" 2>&1 < /dev/null &
+QEMU_PID=$!
+
+echo ">>> Booting VM (ssh port $SSH_PORT)..."
+if ! vm_wait_ssh "$SSH_PORT" "$QEMU_PID" "$BOOT_TIMEOUT"; then
+    echo -e "${RED}>>> FAIL: VM did not come up (see $OUT_DIR/serial.log)${NC}"
+    exit 1
+fi
+T_BOOT=$(now_ms)
+
+# guest <command> - run in the guest, stdin detached
+guest() {
+    vm_ssh "$SSH_PORT" "$@" < /dev/null
+}
+
+# Keep pr_info tracer output off the emulated UART but let warnings and
+# worse through (console loglevel 5), and start from an empty kernel log.
+guest "mount-shared > /dev/null && dmesg -n 5 && dmesg -C"
+
+# Everything the serial console prints from here on belongs to the test
+SERIAL_START=$(stat -c %s "$INST/serial.log" 2>/dev/null || echo 0)
+
+FAIL_REASONS=()
+
+# dmesg_step <step> - move the kernel log since the last step into
+# dmesg.log. A chatty module can wrap the log ring within one workload, so
+# it is drained after every step rather than read once at the end.
+dmesg_step() {
+    echo "=== after $1 ===" >> "$OUT_DIR/dmesg.log"
+    if ! guest "dmesg -c" >> "$OUT_DIR/dmesg.log" 2>&1; then
+        FAIL_REASONS+=("guest unresponsive after $1")
+    fi
+}
+
+# --- Load ---
+echo ">>> insmod $MODULE.ko $PARAMS"
+T0=$(now_ms)
+if ! guest "insmod $VM_SHARE_MOUNT/modules/$MODULE.ko $PARAMS" > "$OUT_DIR/insmod.log" 2>&1; then
+    FAIL_REASONS+=("insmod failed")
+fi
+T_INSMOD=$(( $(now_ms) - T0 ))
+dmesg_step insmod
+
+# --- Workload ---
+T_WORKLOAD=0
+if [ ${#FAIL_REASONS[@]} -eq 0 ]; then
+    echo ">>> Running workload $(basename "$WORKLOAD")..."
+    T0=$(now_ms)
+    if ! vm_ssh_timeout "$WORKLOAD_TIMEOUT" "$SSH_PORT" \
+            "cd $VM_SHARE_MOUNT && env MODULE=$MODULE RESULTS_DIR=$VM_SHARE_MOUNT/results$WORKLOAD_ENV_ARGS bash ./workload.sh" \
+            < /dev/null > "$OUT_DIR/workload.log" 2>&1; then
+        FAIL_REASONS+=("workload failed")
+    fi
+    T_WORKLOAD=$(( $(now_ms) - T0 ))
+
+    if [ -n "$BUDGET" ] && [ "$T_WORKLOAD" -gt $(( BUDGET * 1000 )) ]; then
+        FAIL_REASONS+=("workload over budget (${T_WORKLOAD}ms > ${BUDGET}s)")
+    fi
+    dmesg_step workload
+fi
+
+# --- Collect ---
+guest "mount -t debugfs none /sys/kernel/debug 2>/dev/null; \
+       [ -d /sys/kernel/debug/$MODULE ] && grep -r . /sys/kernel/debug/$MODULE" \
+    > "$OUT_DIR/debugfs.txt" 2>/dev/null || true
+cp -r "$INST/shared/results/." "$OUT_DIR/" 2>/dev/null || true
+
+# --- Unload ---
+T0=$(now_ms)
+if ! guest "rmmod $MODULE" > "$OUT_DIR/rmmod.log" 2>&1; then
+    FAIL_REASONS+=("rmmod failed")
+fi
+T_RMMOD=$(( $(now_ms) - T0 ))
+dmesg_step rmmod
+
+# The serial console also catches what the log ring lost mid-step
+if grep -Eq "$OOPS_PATTERN" "$OUT_DIR/dmesg.log"; then
+    FAIL_REASONS+=("kernel oops/warning in dmesg")
+elif tail -c +$(( SERIAL_START + 1 )) "$INST/serial.log" 2>/dev/null |
+        grep -Eq "$OOPS_PATTERN"; then
+    FAIL_REASONS+=("kernel oops/warning on the serial console")
+fi
+T_TOTAL=$(( $(now_ms) - T_START ))
+
+# --- Summary ---
+if [ ${#FAIL_REASONS[@]} -eq 0 ]; then
+    RESULT="PASS"
+else
+    RESULT="FAIL"
+fi
+
+{
+    echo "module=$MODULE"
+    echo "params=$PARAMS"
+    echo "env=${WORKLOAD_ENV[*]}"
+    echo "workload=$(basename "$WORKLOAD")"
+    echo "result=$RESULT"
+    for reason in "${FAIL_REASONS[@]}"; do
+        echo "reason=$reason"
+    done
+    echo "boot_ms=$(( T_BOOT - T_START ))"
+    echo "insmod_ms=$T_INSMOD"
+    echo "workload_ms=$T_WORKLOAD"
+    echo "rmmod_ms=$T_RMMOD"
+    echo "total_ms=$T_TOTAL"
+} > "$OUT_DIR/summary.txt"
+
+echo ""
+echo "=============================================================================="
+if [ "$RESULT" = "PASS" ]; then
+    echo -e "  ${GREEN}PASS${NC}: $MODULE"
+else
+    echo -e "  ${RED}FAIL${NC}: $MODULE"
+    for reason in "${FAIL_REASONS[@]}"; do
+        echo -e "    ${YELLOW}- $reason${NC}"
+    done
+fi
+echo ""
+echo "  Boot: $(( T_BOOT - T_START ))ms  insmod: ${T_INSMOD}ms  workload: ${T_WORKLOAD}ms  rmmod: ${T_RMMOD}ms"
+echo "  Results: $OUT_DIR"
+echo "=============================================================================="
+
+[ "$RESULT" = "PASS" ]
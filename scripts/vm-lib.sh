@@ -0,0 +1,137 @@
+#!/bin/bash
+
+# ==============================================================================
+# AArch64 Lab - Headless VM Helpers
+# ==============================================================================
+# Sourced by the automation scripts (multi-run.sh, ...). Not meant to be
+# run directly.
+#
+# Guest access goes over the SSH hostfwd port using the lab's root/root
+# credentials, so 'sshpass' must be installed on the host (make deps).
+# ==============================================================================
+
+# Guest credentials (set in setup_debian.sh)
+VM_USER="root"
+VM_PASSWORD="root"
+
+# Where the guest mounts the shared folder (see mount-shared in the rootfs)
+VM_SHARE_MOUNT="/mnt/shared"
+
+VM_SSH_OPTS=(
+    -o StrictHostKeyChecking=no
+    -o UserKnownHostsFile=/dev/null
+    -o LogLevel=ERROR
+    -o ConnectTimeout=5
+)
+
+# vm_require_tools - fail early if host tools needed for automation are missing
+vm_require_tools() {
+    local tool
+    for tool in qemu-system-aarch64 qemu-img sshpass ssh; do
+        if ! command -v "$tool" > /dev/null; then
+            echo "Error: '$tool' not found. Run 'make deps' first."
+            exit 1
+        fi
+    done
+}
+
+# vm_ssh <port> <command...> - run a command in the guest as root
+vm_ssh() {
+    local port="$1"
+    shift
+    sshpass -p "$VM_PASSWORD" ssh "${VM_SSH_OPTS[@]}" -p "$port" \
+        "$VM_USER@localhost" "$@"
+}
+
+# vm_ssh_timeout <secs> <port> <command...> - vm_ssh with a time limit
+vm_ssh_timeout() {
+    local secs="$1"
+    local port="$2"
+    shift 2
+    timeout "$secs" sshpass -p "$VM_PASSWORD" ssh "${VM_SSH_OPTS[@]}" \
+        -p "$port" "$VM_USER@localhost" "$@"
+}
+
+# vm_port_busy <port> - true if something on the host accepts on <port>
+vm_port_busy() {
+    (exec 3<> "/dev/tcp/127.0.0.1/$1") 2>/dev/null
+}
+
+# vm_find_port <base> - print the first port from <base> up that nothing
+# listens on. Only a probe: a process binding it before QEMU does still
+# wins, and QEMU then exits, which vm_wait_ssh notices.
+vm_find_port() {
+    local port="$1"
+    local last=$(( $1 + 100 ))
+
+    while (( port < last )); do
+        if ! vm_port_busy "$port"; then
+            echo "$port"
+            return 0
+        fi
+        port=$(( port + 1 ))
+    done
+    echo "Error: no free port in $1-$(( last - 1 ))" >&2
+    return 1
+}
+
+# vm_instance_dir <vms-dir> <name> - create and print a fresh instance
+# directory <vms-dir>/<name>.XXXXXX, so concurrent runs never share one
+vm_instance_dir() {
+    mkdir -p "$1"
+    mktemp -d "$1/$2.XXXXXX"
+}
+
+# vm_create_overlay <overlay> <golden> - fresh thin qcow2 overlay on golden
+vm_create_overlay() {
+    local overlay="$1"
+    local golden="$2"
+    local backing
+
+    mkdir -p "$(dirname "$overlay")"
+    rm -f "$overlay"
+    backing="$(realpath --relative-to="$(dirname "$overlay")" "$golden")"
+    qemu-img create -f qcow2 -F qcow2 -b "$backing" "$overlay" > /dev/null
+}
+
+# vm_wait_ssh <port> <qemu-pid> <timeout-secs> - wait until the guest answers
+vm_wait_ssh() {
+    local port="$1"
+    local pid="$2"
+    local timeout="$3"
+    local start=$SECONDS
+
+    while (( SECONDS - start < timeout )); do
+        if ! kill -0 "$pid" 2>/dev/null; then
+            return 1
+        fi
+        if vm_ssh "$port" true 2>/dev/null; then
+            return 0
+        fi
+        sleep 2
+    done
+    return 1
+}
+
+# vm_stop <qemu-pid> [qmp-socket] - graceful QMP quit, then kill
+vm_stop() {
+    local pid="$1"
+    local qmp="$2"
+    local i
+
+    if ! kill -0 "$pid" 2>/dev/null; then
+        return 0
+    fi
+
+    if [ -n "$qmp" ] && [ -S "$qmp" ] && command -v socat > /dev/null; then
+        printf '%s\n' '{"execute":"qmp_capabilities"}' '{"execute":"quit"}' |
+            socat - "UNIX-CONNECT:$qmp" > /dev/null 2>&1 || true
+        for i in 1 2 3 4 5; do
+            kill -0 "$pid" 2>/dev/null || return 0
+            sleep 1
+        done
+    fi
+
+    kill "$pid" 2>/dev/null || true
+    wait "$pid" 2>/dev/null || true
+}
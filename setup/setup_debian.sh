@@ -6,11 +6,23 @@
 # Creates a full Debian 12 (Bookworm) rootfs for ARM64 with development tools.
 #
 # Architecture (Layered Images):
-#   Layer 1: debian-rootfs-base.img (raw)   - Base Debian OS from debootstrap
-#   Layer 2: debian-rootfs.qcow2            - Golden image with config + modules
-#   Layer 3: debian-runtime.qcow2           - Disposable runtime (via reset)
+#   Layer 1a: debian-rootfs-base.img (raw)  - Base Debian OS from debootstrap
+#   Layer 1b: debian-rootfs-pkgs.qcow2      - Installed packages (PACKAGES_*)
+#   Layer 2:  debian-rootfs.qcow2           - Golden image with config + modules
+#   Layer 3:  debian-runtime.qcow2          - Disposable runtime (via reset)
 #
-# Usage: sudo ./setup/setup_debian.sh
+# Each build layer records a hash of its inputs and is only rebuilt when
+# they change (or a layer below it was rebuilt): editing the package list
+# rebuilds 1b and 2, editing the configuration rebuilds 2 only.
+#
+# Cache (.cache/rootfs/, survives 'make clean'):
+#   debootstrap-<release>-arm64.tgz   Base packages (debootstrap --make-tarball)
+#   apt/archives, apt/lists           Bind-mounted into the chroot for apt
+#   stamps/<layer>                    Input hash each layer was built from
+#
+# Once the cache is warm the build needs no network (--offline).
+#
+# Usage: sudo ./setup/setup_debian.sh [--offline] [--rebuild LAYER]
 # ==============================================================================
 
 set -e
@@ -20,11 +32,16 @@ SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
 LAB_ROOT="$(dirname "$SCRIPT_DIR")"
 
 IMAGE_BASE_NAME="$LAB_ROOT/debian-rootfs-base.img"
+IMAGE_PKGS_NAME="$LAB_ROOT/debian-rootfs-pkgs.qcow2"
 IMAGE_NAME="$LAB_ROOT/debian-rootfs.qcow2"
-IMAGE_SIZE="4096"  # 4GB for room for dev tools
+IMAGE_RUNTIME="$LAB_ROOT/debian-runtime.qcow2"
+IMAGE_SIZE="4096"  # 4GB for room for dev tools (sparse, grows as used)
 MOUNT_DIR="$LAB_ROOT/mnt_rootfs"
+NBD_DEV="/dev/nbd0"
 DEBIAN_RELEASE="bookworm"
+DEBIAN_MIRROR="http://deb.debian.org/debian/"
 KERNEL_SRC="$LAB_ROOT/linux-6.6"
+CACHE_DIR="${ROOTFS_CACHE:-$LAB_ROOT/.cache/rootfs}"
 
 # Packages to install in the rootfs
 PACKAGES_BASE="systemd systemd-sysv udev kmod"
@@ -36,6 +53,66 @@ PACKAGES_DEBUG="linux-perf crash"
 
 ALL_PACKAGES="$PACKAGES_BASE $PACKAGES_NET $PACKAGES_DEV $PACKAGES_EDIT $PACKAGES_UTIL"
 
+APT_SOURCES="deb http://deb.debian.org/debian $DEBIAN_RELEASE main contrib non-free non-free-firmware
+deb http://deb.debian.org/debian $DEBIAN_RELEASE-updates main contrib non-free non-free-firmware
+deb http://security.debian.org/debian-security $DEBIAN_RELEASE-security main contrib non-free non-free-firmware"
+
+# Options
+OFFLINE=0
+REBUILD=""
+
+usage() {
+    echo "Usage: sudo $0 [OPTIONS]"
+    echo ""
+    echo "Options:"
+    echo "  --offline          Don't touch the network; build from the cache"
+    echo "  --rebuild LAYER    Rebuild LAYER and everything above it:"
+    echo "                       base    debootstrap (1a)"
+    echo "                       pkgs    package install (1b)"
+    echo "                       golden  configuration + kernel modules (2)"
+    echo "  --cache-dir DIR    Cache directory (default: .cache/rootfs, or \$ROOTFS_CACHE)"
+    echo "  --help, -h         Show this help"
+}
+
+# --- Parse Arguments ---
+while [[ $# -gt 0 ]]; do
+    case "$1" in
+        --offline)
+            OFFLINE=1
+            shift
+            ;;
+        --rebuild)
+            REBUILD="$2"
+            shift 2
+            ;;
+        --cache-dir)
+            CACHE_DIR="$2"
+            shift 2
+            ;;
+        --help|-h)
+            usage
+            exit 0
+            ;;
+        *)
+            echo "Unknown option: $1"
+            echo "Use --help for usage information."
+            exit 1
+            ;;
+    esac
+done
+
+# Layers at or above this level are rebuilt; lowered when a layer rebuilds
+case "$REBUILD" in
+    "")     FORCE_FROM=99 ;;
+    base)   FORCE_FROM=1 ;;
+    pkgs)   FORCE_FROM=2 ;;
+    golden) FORCE_FROM=3 ;;
+    *)
+        echo "Error: Unknown layer '$REBUILD' (base, pkgs or golden)"
+        exit 1
+        ;;
+esac
+
 # --- Check for Root ---
 if [ "$EUID" -ne 0 ]; then
     echo "Error: This script must be run as root."
@@ -43,12 +120,19 @@ if [ "$EUID" -ne 0 ]; then
     exit 1
 fi
 
+DEBOOTSTRAP_TARBALL="$CACHE_DIR/debootstrap-$DEBIAN_RELEASE-arm64.tgz"
+APT_ARCHIVES="$CACHE_DIR/apt/archives"
+APT_LISTS="$CACHE_DIR/apt/lists"
+STAMP_DIR="$CACHE_DIR/stamps"
+
+mkdir -p "$APT_ARCHIVES/partial" "$APT_LISTS/partial" "$STAMP_DIR"
+
 # --- Cleanup Trap ---
 cleanup() {
     echo ">>> Cleaning up..."
 
     # Unmount bind mounts first
-    for mount in sys proc dev; do
+    for mount in var/cache/apt/archives var/lib/apt/lists sys proc dev; do
         if mountpoint -q "$MOUNT_DIR/$mount" 2>/dev/null; then
             umount "$MOUNT_DIR/$mount" 2>/dev/null || true
         fi
@@ -60,8 +144,8 @@ cleanup() {
     fi
 
     # Disconnect NBD
-    if [ -e /dev/nbd0 ] && lsblk /dev/nbd0 &>/dev/null; then
-        qemu-nbd --disconnect /dev/nbd0 2>/dev/null || true
+    if [ -e "$NBD_DEV" ] && lsblk "$NBD_DEV" &>/dev/null; then
+        qemu-nbd --disconnect "$NBD_DEV" 2>/dev/null || true
     fi
 
     # Remove mount dir
@@ -71,31 +155,130 @@ cleanup() {
 }
 trap cleanup EXIT
 
-# --- Install Build Dependencies ---
-echo ">>> Step 1: Installing host dependencies..."
-apt-get update -qq
-apt-get install -y debootstrap qemu-user-static binfmt-support qemu-utils
+# ==============================================================================
+# Helpers
+# ==============================================================================
+
+# hash_of <input...> - short content hash used as a layer stamp
+hash_of() {
+    printf '%s\n' "$@" | sha256sum | cut -c1-16
+}
+
+# needs_build <level> <image> <layer> <hash> - true if the layer must be
+# (re)built: forced, missing, or built from different inputs
+needs_build() {
+    local level="$1" image="$2" layer="$3" hash="$4"
+
+    if [ "$level" -ge "$FORCE_FROM" ] || [ ! -f "$image" ] ||
+       [ "$(cat "$STAMP_DIR/$layer" 2>/dev/null)" != "$hash" ]; then
+        # Everything above this layer sits on top of it
+        FORCE_FROM="$level"
+        rm -f "$STAMP_DIR/$layer"
+        return 0
+    fi
+    echo ">>> Layer '$layer' is up to date ($hash), skipping."
+    return 1
+}
+
+# attach <qcow2> - connect the image to $NBD_DEV and mount it at $MOUNT_DIR
+attach() {
+    modprobe nbd max_part=8
+    qemu-nbd --connect="$NBD_DEV" "$1"
+    sleep 1
+    mkdir -p "$MOUNT_DIR"
+    mount "$NBD_DEV" "$MOUNT_DIR"
+}
+
+detach() {
+    sync
+    umount "$MOUNT_DIR"
+    qemu-nbd --disconnect "$NBD_DEV" > /dev/null
+}
+
+# Virtual filesystems and the shared apt cache for running apt in the chroot
+mount_chroot() {
+    mount --bind /dev "$MOUNT_DIR/dev"
+    mount --bind /proc "$MOUNT_DIR/proc"
+    mount --bind /sys "$MOUNT_DIR/sys"
+    mkdir -p "$MOUNT_DIR/var/cache/apt/archives" "$MOUNT_DIR/var/lib/apt/lists"
+    mount --bind "$APT_ARCHIVES" "$MOUNT_DIR/var/cache/apt/archives"
+    mount --bind "$APT_LISTS" "$MOUNT_DIR/var/lib/apt/lists"
+}
+
+umount_chroot() {
+    umount "$MOUNT_DIR/var/lib/apt/lists"
+    umount "$MOUNT_DIR/var/cache/apt/archives"
+    umount "$MOUNT_DIR/sys"
+    umount "$MOUNT_DIR/proc"
+    umount "$MOUNT_DIR/dev"
+}
+
+# dpkg skips its fsyncs: the image is synced once when it is detached
+chroot_apt() {
+    chroot "$MOUNT_DIR" env DEBIAN_FRONTEND=noninteractive \
+        apt-get -o Dpkg::Options::=--force-unsafe-io "$@"
+}
 
 # ==============================================================================
-# PHASE 1: The Base Image (Raw)
+# Install Build Dependencies
 # ==============================================================================
-if [ -f "$IMAGE_BASE_NAME" ]; then
-    echo ">>> Base image '$IMAGE_BASE_NAME' found. Skipping debootstrap."
+echo ">>> Step 1: Checking host dependencies..."
+
+MISSING=""
+command -v debootstrap > /dev/null || MISSING="$MISSING debootstrap"
+[ -x /usr/bin/qemu-aarch64-static ] || MISSING="$MISSING qemu-user-static"
+command -v update-binfmts > /dev/null || MISSING="$MISSING binfmt-support"
+{ command -v qemu-img && command -v qemu-nbd; } > /dev/null || MISSING="$MISSING qemu-utils"
+
+if [ -z "$MISSING" ]; then
+    echo "    All present."
+elif [ "$OFFLINE" = 1 ]; then
+    echo "Error: Missing host packages:$MISSING (cannot install with --offline)"
+    exit 1
 else
-    echo ">>> Base image not found. Building from scratch (this takes ~10 minutes)..."
+    apt-get update -qq
+    apt-get install -y $MISSING
+fi
 
-    # Create Raw Image
-    echo ">>> Creating ${IMAGE_SIZE}MB raw image..."
-    dd if=/dev/zero of="$IMAGE_BASE_NAME" bs=1M count="$IMAGE_SIZE" status=progress
-    mkfs.ext4 -F "$IMAGE_BASE_NAME"
+# ==============================================================================
+# LAYER 1a: The Base Image (Raw)
+# ==============================================================================
+BASE_HASH=$(hash_of base "$DEBIAN_RELEASE" "$DEBIAN_MIRROR" "$IMAGE_SIZE" "$APT_SOURCES")
+
+echo ">>> Step 2: Base image (debootstrap)..."
+if needs_build 1 "$IMAGE_BASE_NAME" base "$BASE_HASH"; then
+    # Downloaded packages are kept, so only the first build needs network
+    if [ -f "$DEBOOTSTRAP_TARBALL" ]; then
+        echo ">>> Using cached $(basename "$DEBOOTSTRAP_TARBALL")"
+    elif [ "$OFFLINE" = 1 ]; then
+        echo "Error: No cached debootstrap tarball at $DEBOOTSTRAP_TARBALL"
+        echo "Run once without --offline to fill the cache."
+        exit 1
+    else
+        echo ">>> Downloading base packages (debootstrap Stage 1)..."
+        TARBALL_WORK="$(mktemp -d)"
+        debootstrap --arch=arm64 --foreign \
+            --make-tarball="${DEBOOTSTRAP_TARBALL%.tgz}.partial.tgz" \
+            "$DEBIAN_RELEASE" "$TARBALL_WORK" "$DEBIAN_MIRROR"
+        mv "${DEBOOTSTRAP_TARBALL%.tgz}.partial.tgz" "$DEBOOTSTRAP_TARBALL"
+        rm -rf "$TARBALL_WORK"
+    fi
+
+    # Create sparse raw image: no zeroes are written
+    echo ">>> Creating ${IMAGE_SIZE}MB sparse raw image..."
+    rm -f "$IMAGE_BASE_NAME"
+    truncate -s "${IMAGE_SIZE}M" "$IMAGE_BASE_NAME"
+    mkfs.ext4 -F -q "$IMAGE_BASE_NAME"
 
     # Mount Raw Image
     mkdir -p "$MOUNT_DIR"
     mount -o loop "$IMAGE_BASE_NAME" "$MOUNT_DIR"
 
-    # Debootstrap Stage 1 (download packages)
-    echo ">>> Running debootstrap Stage 1..."
-    debootstrap --arch=arm64 --foreign "$DEBIAN_RELEASE" "$MOUNT_DIR" http://deb.debian.org/debian/
+    # Debootstrap Stage 1 (unpack cached packages)
+    echo ">>> Running debootstrap Stage 1 (from cache)..."
+    debootstrap --arch=arm64 --foreign \
+        --unpack-tarball="$DEBOOTSTRAP_TARBALL" \
+        "$DEBIAN_RELEASE" "$MOUNT_DIR" "$DEBIAN_MIRROR"
 
     # Copy QEMU static binary for Stage 2
     cp /usr/bin/qemu-aarch64-static "$MOUNT_DIR/usr/bin/"
@@ -105,70 +288,60 @@ else
     chroot "$MOUNT_DIR" /debootstrap/debootstrap --second-stage
 
     # Setup apt sources
-    cat <<EOF > "$MOUNT_DIR/etc/apt/sources.list"
-deb http://deb.debian.org/debian $DEBIAN_RELEASE main contrib non-free non-free-firmware
-deb http://deb.debian.org/debian $DEBIAN_RELEASE-updates main contrib non-free non-free-firmware
-deb http://security.debian.org/debian-security $DEBIAN_RELEASE-security main contrib non-free non-free-firmware
-EOF
-
-    # Mount virtual filesystems for package installation
-    mount --bind /dev "$MOUNT_DIR/dev"
-    mount --bind /proc "$MOUNT_DIR/proc"
-    mount --bind /sys "$MOUNT_DIR/sys"
-
-    # Install packages
-    echo ">>> Installing development packages..."
-    chroot "$MOUNT_DIR" apt-get update
-    chroot "$MOUNT_DIR" apt-get install -y --no-install-recommends $ALL_PACKAGES
-
-    # Clean up apt cache
-    chroot "$MOUNT_DIR" apt-get clean
-    chroot "$MOUNT_DIR" rm -rf /var/lib/apt/lists/*
-
-    # Unmount virtual filesystems
-    umount "$MOUNT_DIR/sys"
-    umount "$MOUNT_DIR/proc"
-    umount "$MOUNT_DIR/dev"
+    echo "$APT_SOURCES" > "$MOUNT_DIR/etc/apt/sources.list"
 
     # Unmount base image
+    sync
     umount "$MOUNT_DIR"
+    echo "$BASE_HASH" > "$STAMP_DIR/base"
     echo ">>> Base image build complete."
 fi
 
 # ==============================================================================
-# PHASE 2: The Overlay Image (QCOW2)
+# LAYER 1b: Packages (QCOW2 on the base image)
 # ==============================================================================
-echo ">>> Step 2: Creating QCOW2 overlay..."
-
-if [ -f "$IMAGE_NAME" ]; then
-    echo "    Removing old overlay..."
-    rm "$IMAGE_NAME"
-fi
+PKGS_HASH=$(hash_of pkgs "$BASE_HASH" "$ALL_PACKAGES")
 
-# Create QCOW2 backed by raw base
-qemu-img create -f qcow2 -F raw -b "$(basename "$IMAGE_BASE_NAME")" "$IMAGE_NAME"
+echo ">>> Step 3: Package layer..."
+if needs_build 2 "$IMAGE_PKGS_NAME" pkgs "$PKGS_HASH"; then
+    rm -f "$IMAGE_PKGS_NAME"
+    qemu-img create -f qcow2 -F raw -b "$(basename "$IMAGE_BASE_NAME")" "$IMAGE_PKGS_NAME"
 
-# ==============================================================================
-# PHASE 3: Configure the Overlay
-# ==============================================================================
-echo ">>> Step 3: Mounting overlay for configuration..."
+    attach "$IMAGE_PKGS_NAME"
+    mount_chroot
 
-# Load NBD module
-modprobe nbd max_part=8
+    # Package lists and .debs live in the cache, not in the image
+    if [ "$OFFLINE" = 1 ]; then
+        echo ">>> Offline: using cached package lists"
+    elif ! chroot_apt update; then
+        echo ">>> WARNING: apt-get update failed, using cached package lists"
+    fi
+    if [ -z "$(ls "$APT_LISTS" | grep -v -e '^partial$' -e '^lock$')" ]; then
+        echo "Error: No package lists in $APT_LISTS"
+        exit 1
+    fi
 
-# Connect QCOW2 to NBD
-qemu-nbd --connect=/dev/nbd0 "$IMAGE_NAME"
-sleep 1
+    echo ">>> Installing development packages..."
+    if [ "$OFFLINE" = 1 ]; then
+        chroot_apt install -y --no-install-recommends --no-download $ALL_PACKAGES
+    else
+        chroot_apt install -y --no-install-recommends $ALL_PACKAGES
+    fi
 
-# Mount
-mkdir -p "$MOUNT_DIR"
-mount /dev/nbd0 "$MOUNT_DIR"
+    umount_chroot
+    detach
+    echo "$PKGS_HASH" > "$STAMP_DIR/pkgs"
+    echo ">>> Package layer build complete."
+fi
 
-echo ">>> Step 4: Configuring system..."
+# ==============================================================================
+# LAYER 2: The Golden Image (QCOW2 on the package layer)
+# ==============================================================================
 
-# --- Hostname ---
-echo "aarch64-lab" > "$MOUNT_DIR/etc/hostname"
-cat <<EOF > "$MOUNT_DIR/etc/hosts"
+configure_system() {
+    # --- Hostname ---
+    echo "aarch64-lab" > "$MOUNT_DIR/etc/hostname"
+    cat <<EOF > "$MOUNT_DIR/etc/hosts"
 127.0.0.1   localhost
 127.0.1.1   aarch64-lab
 
@@ -177,8 +350,8 @@ ff02::1     ip6-allnodes
 ff02::2     ip6-allrouters
 EOF
 
-# --- Network Configuration ---
-cat <<EOF > "$MOUNT_DIR/etc/network/interfaces"
+    # --- Network Configuration ---
+    cat <<EOF > "$MOUNT_DIR/etc/network/interfaces"
 auto lo
 iface lo inet loopback
 
@@ -186,32 +359,32 @@ auto enp0s1
 iface enp0s1 inet dhcp
 EOF
 
-# --- Root Password (root:root) ---
-echo "root:root" | chroot "$MOUNT_DIR" chpasswd
+    # --- Root Password (root:root) ---
+    echo "root:root" | chroot "$MOUNT_DIR" chpasswd
 
-# --- Enable Serial Console ---
-chroot "$MOUNT_DIR" systemctl enable serial-getty@ttyAMA0.service 2>/dev/null || true
+    # --- Enable Serial Console ---
+    chroot "$MOUNT_DIR" systemctl enable serial-getty@ttyAMA0.service 2>/dev/null || true
 
-# --- SSH Configuration ---
-# Allow root login and password auth for lab environment
-if [ -f "$MOUNT_DIR/etc/ssh/sshd_config" ]; then
-    sed -i 's/#PermitRootLogin.*/PermitRootLogin yes/' "$MOUNT_DIR/etc/ssh/sshd_config"
-    sed -i 's/#PasswordAuthentication.*/PasswordAuthentication yes/' "$MOUNT_DIR/etc/ssh/sshd_config"
-    chroot "$MOUNT_DIR" systemctl enable ssh 2>/dev/null || true
-fi
+    # --- SSH Configuration ---
+    # Allow root login and password auth for lab environment
+    if [ -f "$MOUNT_DIR/etc/ssh/sshd_config" ]; then
+        sed -i 's/#PermitRootLogin.*/PermitRootLogin yes/' "$MOUNT_DIR/etc/ssh/sshd_config"
+        sed -i 's/#PasswordAuthentication.*/PasswordAuthentication yes/' "$MOUNT_DIR/etc/ssh/sshd_config"
+        chroot "$MOUNT_DIR" systemctl enable ssh 2>/dev/null || true
+    fi
 
-# --- Fstab ---
-cat <<EOF > "$MOUNT_DIR/etc/fstab"
+    # --- Fstab ---
+    cat <<EOF > "$MOUNT_DIR/etc/fstab"
 /dev/vda    /       ext4    defaults,noatime    0 1
 # Shared folder (mount manually or add to fstab after boot)
 # hostshare  /mnt    9p      trans=virtio,version=9p2000.L,nofail 0 0
 EOF
 
-# --- Create mount point for shared folder ---
-mkdir -p "$MOUNT_DIR/mnt"
+    # --- Create mount point for shared folder ---
+    mkdir -p "$MOUNT_DIR/mnt"
 
-# --- Convenience script to mount shared folder ---
-cat <<'EOF' > "$MOUNT_DIR/usr/local/bin/mount-shared"
+    # --- Convenience script to mount shared folder ---
+    cat <<'EOF' > "$MOUNT_DIR/usr/local/bin/mount-shared"
 #!/bin/bash
 mkdir -p /mnt/shared
 if ! mountpoint -q /mnt/shared; then
@@ -221,10 +394,10 @@ else
     echo "Shared folder already mounted at /mnt"
 fi
 EOF
-chmod +x "$MOUNT_DIR/usr/local/bin/mount-shared"
+    chmod +x "$MOUNT_DIR/usr/local/bin/mount-shared"
 
-# --- Welcome message ---
-cat <<'EOF' > "$MOUNT_DIR/etc/motd"
+    # --- Welcome message ---
+    cat <<'EOF' > "$MOUNT_DIR/etc/motd"
 ================================================================================
   AArch64 Kernel Development Lab - Debian 12 (Bookworm)
 ================================================================================
@@ -238,8 +411,8 @@ cat <<'EOF' > "$MOUNT_DIR/etc/motd"
 ================================================================================
 EOF
 
-# --- Shell configuration ---
-cat <<'EOF' >> "$MOUNT_DIR/root/.bashrc"
+    # --- Shell configuration ---
+    cat <<'EOF' >> "$MOUNT_DIR/root/.bashrc"
 # Lab aliases
 alias ll='ls -la'
 alias la='ls -A'
@@ -253,29 +426,67 @@ alias mnt='mount-shared'
 # Prompt with hostname
 PS1='\[\033[01;31m\]\u@\h\[\033[00m\]:\[\033[01;34m\]\w\[\033[00m\]\$ '
 EOF
+}
 
-# ==============================================================================
-# PHASE 4: Install Kernel Modules
-# ==============================================================================
-echo ">>> Step 5: Installing kernel modules..."
-
-if [ -d "$KERNEL_SRC" ]; then
-    echo "    Found kernel source at $KERNEL_SRC"
+install_kernel_modules() {
+    if [ -d "$KERNEL_SRC" ]; then
+        echo "    Found kernel source at $KERNEL_SRC"
+
+        # Check if modules were built
+        if [ -f "$KERNEL_SRC/modules.order" ]; then
+            make -C "$KERNEL_SRC" \
+                ARCH=arm64 \
+                CROSS_COMPILE=aarch64-linux-gnu- \
+                INSTALL_MOD_PATH="$MOUNT_DIR" \
+                modules_install
+            echo "    Kernel modules installed."
+        else
+            echo "    WARNING: Kernel modules not built yet. Run 'make modules' in kernel source."
+        fi
+    else
+        echo "    WARNING: Kernel source not found at $KERNEL_SRC"
+        echo "    Run setup/setup_kernel.sh first to build the kernel."
+    fi
+}
 
-    # Check if modules were built
+# A kernel rebuild changes the modules to install
+kernel_modules_key() {
     if [ -f "$KERNEL_SRC/modules.order" ]; then
-        make -C "$KERNEL_SRC" \
-            ARCH=arm64 \
-            CROSS_COMPILE=aarch64-linux-gnu- \
-            INSTALL_MOD_PATH="$MOUNT_DIR" \
-            modules_install
-        echo "    Kernel modules installed."
+        cat "$KERNEL_SRC/include/config/kernel.release" 2>/dev/null || true
+        stat -c %Y "$KERNEL_SRC/modules.order" "$KERNEL_SRC/Module.symvers" 2>/dev/null || true
     else
-        echo "    WARNING: Kernel modules not built yet. Run 'make modules' in kernel source."
+        echo "none"
+    fi
+}
+
+GOLDEN_HASH=$(hash_of golden "$PKGS_HASH" "$(declare -f configure_system)" "$(kernel_modules_key)")
+
+echo ">>> Step 4: Golden image (configuration + kernel modules)..."
+if needs_build 3 "$IMAGE_NAME" golden "$GOLDEN_HASH"; then
+    if [ -f "$IMAGE_NAME" ]; then
+        echo "    Removing old golden image..."
+        rm "$IMAGE_NAME"
+    fi
+
+    # Create QCOW2 backed by the package layer
+    qemu-img create -f qcow2 -F qcow2 -b "$(basename "$IMAGE_PKGS_NAME")" "$IMAGE_NAME"
+
+    attach "$IMAGE_NAME"
+
+    echo ">>> Configuring system..."
+    configure_system
+
+    echo ">>> Installing kernel modules..."
+    install_kernel_modules
+
+    detach
+    echo "$GOLDEN_HASH" > "$STAMP_DIR/golden"
+    echo ">>> Golden image build complete."
+
+    if [ -f "$IMAGE_RUNTIME" ]; then
+        echo ">>> NOTE: $(basename "$IMAGE_RUNTIME") was made from the old golden image."
+        echo "    Run 'make reset' before starting the VM."
     fi
-else
-    echo "    WARNING: Kernel source not found at $KERNEL_SRC"
-    echo "    Run setup/setup_kernel.sh first to build the kernel."
 fi
 
 # ==============================================================================
@@ -283,11 +494,13 @@ fi
 # ==============================================================================
 echo ""
 echo "=============================================================================="
-echo "  SUCCESS: Debian rootfs created!"
+echo "  SUCCESS: Debian rootfs ready!"
 echo "=============================================================================="
 echo ""
-echo "  Base image:    $IMAGE_BASE_NAME"
-echo "  Golden image:  $IMAGE_NAME"
+echo "  Base image:     $IMAGE_BASE_NAME"
+echo "  Package layer:  $IMAGE_PKGS_NAME"
+echo "  Golden image:   $IMAGE_NAME"
+echo "  Cache:          $CACHE_DIR"
 echo ""
 echo "  Next steps:"
 echo "    1. Run 'make run' to start the VM"
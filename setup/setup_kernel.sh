@@ -57,6 +57,7 @@ echo ">>> Enabling debug options..."
 ./scripts/config --enable CONFIG_DEBUG_INFO
 ./scripts/config --enable CONFIG_DEBUG_INFO_DWARF_TOOLCHAIN_DEFAULT
 ./scripts/config --enable CONFIG_GDB_SCRIPTS
+./scripts/config --enable CONFIG_KALLSYMS_ALL   # data symbols in module kallsyms
 ./scripts/config --enable CONFIG_DEBUG_SECTION_MISMATCH
 
 # KGDB support
@@ -0,0 +1,239 @@
+/*
+ * openat_stress.c - Multi-threaded openat/close load generator
+ *
+ * Runs N threads, each pinned to its own CPU, opening and closing files
+ * from a path set for a fixed time, optionally rate-limited, and reports
+ * per-thread throughput. Used by scripts/smp-sweep.sh to see how the
+ * tracer modules scale with vCPU count.
+ *
+ * Usage:
+ *   ./openat_stress [-t threads] [-d seconds] [-r ops/s/thread]
+ *                   [-p path[,path...]] [-P pathfile] [-n]
+ *
+ *   -t N     threads (default: one per online CPU)
+ *   -d S     duration in seconds (default: 5)
+ *   -r R     per-thread rate limit in opens/s (default: 0 = unlimited)
+ *   -p LIST  comma-separated paths (default: /etc/hostname)
+ *   -P FILE  read paths from FILE, one per line
+ *   -n       don't pin threads to CPUs
+ *
+ * Output: one "thread ..." line per thread, then a "total ..." line, all
+ * key=value so scripts can parse them.
+ *
+ * Build (cross-compile for aarch64):
+ *   aarch64-linux-gnu-gcc -Wall -O2 -static -pthread -o openat_stress openat_stress.c
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_PATHS 1024
+#define CACHELINE 64
+
+/* Each thread's counters live on their own cache line */
+struct worker {
+	pthread_t thread;
+	int id;
+	int cpu;		/* -1 = not pinned */
+	unsigned long ops;
+	unsigned long errors;
+	double seconds;
+} __attribute__((aligned(CACHELINE)));
+
+static const char *paths[MAX_PATHS];
+static int npaths;
+static double rate;
+static volatile int stop;
+static pthread_barrier_t start_barrier;
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void add_path(const char *p)
+{
+	if (npaths == MAX_PATHS) {
+		fprintf(stderr, "too many paths (max %d)\n", MAX_PATHS);
+		exit(1);
+	}
+	paths[npaths++] = p;
+}
+
+static void load_path_list(char *list)
+{
+	char *tok;
+
+	for (tok = strtok(list, ","); tok; tok = strtok(NULL, ","))
+		add_path(tok);
+}
+
+static void load_path_file(const char *file)
+{
+	char line[4096];
+	FILE *f;
+
+	f = fopen(file, "r");
+	if (!f) {
+		perror(file);
+		exit(1);
+	}
+	while (fgets(line, sizeof(line), f)) {
+		line[strcspn(line, "\n")] = '\0';
+		if (line[0])
+			add_path(strdup(line));
+	}
+	fclose(f);
+}
+
+static void *worker_main(void *arg)
+{
+	struct worker *w = arg;
+	struct timespec next;
+	long interval_ns = rate > 0 ? (long)(1e9 / rate) : 0;
+	unsigned long i = w->id;	/* stagger path order across threads */
+	double t0;
+	int fd;
+
+	if (w->cpu >= 0) {
+		cpu_set_t set;
+
+		CPU_ZERO(&set);
+		CPU_SET(w->cpu, &set);
+		if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set))
+			w->cpu = -1;
+	}
+
+	pthread_barrier_wait(&start_barrier);
+	t0 = now();
+	clock_gettime(CLOCK_MONOTONIC, &next);
+
+	while (!stop) {
+		fd = open(paths[i++ % npaths], O_RDONLY);
+		if (fd < 0)
+			w->errors++;
+		else
+			close(fd);
+		w->ops++;
+
+		if (interval_ns) {
+			next.tv_nsec += interval_ns;
+			while (next.tv_nsec >= 1000000000L) {
+				next.tv_nsec -= 1000000000L;
+				next.tv_sec++;
+			}
+			clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+		}
+	}
+
+	w->seconds = now() - t0;
+	return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+	struct worker *workers;
+	cpu_set_t allowed;
+	int cpus[CPU_SETSIZE];
+	int ncpus = 0;
+	int nthreads = 0;
+	double duration = 5;
+	int pin = 1;
+	unsigned long total_ops = 0, total_errors = 0;
+	double total_rate = 0;
+	int opt, i;
+
+	while ((opt = getopt(argc, argv, "t:d:r:p:P:n")) != -1) {
+		switch (opt) {
+		case 't':
+			nthreads = atoi(optarg);
+			break;
+		case 'd':
+			duration = atof(optarg);
+			break;
+		case 'r':
+			rate = atof(optarg);
+			break;
+		case 'p':
+			load_path_list(optarg);
+			break;
+		case 'P':
+			load_path_file(optarg);
+			break;
+		case 'n':
+			pin = 0;
+			break;
+		default:
+			fprintf(stderr,
+				"Usage: %s [-t threads] [-d seconds] [-r ops/s] "
+				"[-p path,...] [-P pathfile] [-n]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	if (npaths == 0)
+		add_path("/etc/hostname");
+
+	/* Pin to the CPUs we are allowed on, round-robin */
+	if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+		for (i = 0; i < CPU_SETSIZE; i++)
+			if (CPU_ISSET(i, &allowed))
+				cpus[ncpus++] = i;
+	}
+	if (nthreads <= 0)
+		nthreads = ncpus > 0 ? ncpus : 1;
+
+	workers = aligned_alloc(CACHELINE, sizeof(*workers) * nthreads);
+	if (!workers) {
+		perror("aligned_alloc");
+		return 1;
+	}
+	memset(workers, 0, sizeof(*workers) * nthreads);
+
+	pthread_barrier_init(&start_barrier, NULL, nthreads + 1);
+
+	for (i = 0; i < nthreads; i++) {
+		workers[i].id = i;
+		workers[i].cpu = (pin && ncpus) ? cpus[i % ncpus] : -1;
+		if (pthread_create(&workers[i].thread, NULL, worker_main,
+				   &workers[i])) {
+			perror("pthread_create");
+			return 1;
+		}
+	}
+
+	pthread_barrier_wait(&start_barrier);
+	usleep((useconds_t)(duration * 1e6));
+	stop = 1;
+
+	for (i = 0; i < nthreads; i++) {
+		struct worker *w = &workers[i];
+		double ops_s;
+
+		pthread_join(w->thread, NULL);
+		ops_s = w->seconds > 0 ? w->ops / w->seconds : 0;
+		printf("thread id=%d cpu=%d ops=%lu errors=%lu seconds=%.3f ops_per_sec=%.1f\n",
+		       w->id, w->cpu, w->ops, w->errors, w->seconds, ops_s);
+		total_ops += w->ops;
+		total_errors += w->errors;
+		total_rate += ops_s;
+	}
+
+	printf("total threads=%d paths=%d ops=%lu errors=%lu ops_per_sec=%.1f ops_per_sec_per_thread=%.1f\n",
+	       nthreads, npaths, total_ops, total_errors, total_rate,
+	       total_rate / nthreads);
+
+	free(workers);
+	return 0;
+}
@@ -0,0 +1,417 @@
+/*
+ * symcount.c - QEMU TCG plugin for deterministic overhead profiling
+ *
+ * Loaded by 'scripts/start.sh --profile DIR'. Counts guest instructions
+ * per translation block and, for a small set of tracked kernel functions,
+ * the instructions executed from entry to return *including callees*.
+ * Unlike wall clock, these counts are the same no matter how loaded the
+ * host is.
+ *
+ * The run is split into phases driven by a control file, appended to as
+ * the run goes on (see scripts/profile.sh):
+ *
+ *   phase trace_openat
+ *   track __arm64_sys_openat ffff800080312a40
+ *   track trace_openat_handler ffff80007a8b0010
+ *
+ * Only the last "phase" line and the track lines after it count, so a
+ * phase switch is one append. When the file changes, the finished phase
+ * is appended to the output file, all counters reset, and
+ * "# phase <name> begin" is written so whoever switched knows the new
+ * phase is live.
+ *
+ * Inclusive counting: a tracked function goes active when a TB starting at
+ * its entry address executes. While active, every TB adds its instruction
+ * count; a TB ending in BL/BLR deepens the call depth, one ending in RET
+ * either pops a level or, at depth 0, closes the call. Calls, returns and
+ * exception returns inside interrupts taken in the window balance out, so
+ * their instructions are counted too - profile with -smp 1 and an idle
+ * guest for stable numbers. A tracked call that sleeps (context switch)
+ * throws its depth off, so track functions on paths that don't block.
+ *
+ * Plugin arguments:
+ *   ctl=FILE    control file (required)
+ *   out=FILE    output file (required)
+ *   top=N       hottest TBs written per phase (default 2000)
+ *
+ * Build: make -C tools/tcg-plugin
+ */
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <glib.h>
+#include <qemu-plugin.h>
+
+QEMU_PLUGIN_EXPORT int qemu_plugin_version = QEMU_PLUGIN_VERSION;
+
+/* scripts/profile.sh reads this value; keep it a plain number */
+#define MAX_TRACK	16
+#define NAME_LEN	64
+
+/* Check the control file every 2^16 kernel TB executions */
+#define POLL_MASK	((1u << 16) - 1)
+
+/* AArch64 kernel addresses have the top 16 bits set */
+#define KERNEL_VADDR(a)	((a) >= 0xffff000000000000ULL)
+
+enum tb_kind {
+	TB_OTHER,
+	TB_CALL,	/* ends in BL / BLR */
+	TB_RET,		/* ends in RET */
+};
+
+struct tb_info {
+	uint64_t key;		/* see tb_key() */
+	uint64_t vaddr;
+	uint32_t n_insns;
+	uint32_t kind;
+	uint64_t execs;		/* this phase, atomic */
+};
+
+struct track {
+	char name[NAME_LEN];
+	uint64_t entry;
+	uint64_t calls;		/* atomic */
+	uint64_t insns;		/* atomic */
+};
+
+/* Per-vCPU, per-phase state. Only touched by its own vCPU thread. */
+struct vcpu_state {
+	uint64_t kernel_insns;
+	uint64_t user_insns;
+	int64_t depth[MAX_TRACK];
+	bool active[MAX_TRACK];
+};
+
+/*
+ * Everything that is reset at a phase boundary. A new set is published
+ * with an atomic pointer swap; the old one is kept (never freed) because
+ * other vCPUs may still be inside a callback using it.
+ */
+struct phase {
+	char name[NAME_LEN];
+	int ntrack;
+	struct track track[MAX_TRACK];
+	struct vcpu_state *vcpu;
+};
+
+static struct phase *cur_phase;
+static unsigned int max_vcpus;
+static unsigned int top_n = 2000;
+static char *ctl_path;
+static FILE *out;
+
+static GMutex lock;		/* tb table, phase switches, output */
+static GHashTable *tbs;		/* tb_key() -> struct tb_info */
+static uint64_t poll_tick;
+static struct stat ctl_stat;
+
+/* ═══════════════════════════════════════════════════════════════════
+ *                       PHASE MANAGEMENT
+ * ═══════════════════════════════════════════════════════════════════ */
+
+static struct phase *phase_parse(const char *path)
+{
+	struct phase *p;
+	char line[256], name[NAME_LEN];
+	uint64_t addr;
+	FILE *f;
+
+	p = g_new0(struct phase, 1);
+	p->vcpu = g_new0(struct vcpu_state, max_vcpus);
+	g_strlcpy(p->name, "unnamed", sizeof(p->name));
+
+	f = fopen(path, "r");
+	if (!f)
+		return p;
+
+	while (fgets(line, sizeof(line), f)) {
+		if (sscanf(line, "phase %63s", name) == 1) {
+			/* A later block replaces the earlier ones */
+			g_strlcpy(p->name, name, sizeof(p->name));
+			p->ntrack = 0;
+		} else if (sscanf(line, "track %63s %" SCNx64, name, &addr) == 2) {
+			if (p->ntrack == MAX_TRACK) {
+				fprintf(stderr, "symcount: phase %s: more than %d "
+					"tracked functions, ignoring %s\n",
+					p->name, MAX_TRACK, name);
+				continue;
+			}
+			g_strlcpy(p->track[p->ntrack].name, name, NAME_LEN);
+			p->track[p->ntrack].entry = addr;
+			p->ntrack++;
+		}
+	}
+	fclose(f);
+	return p;
+}
+
+static gint cmp_tb_cost(gconstpointer a, gconstpointer b)
+{
+	const struct tb_info *ta = *(const struct tb_info **)a;
+	const struct tb_info *tb = *(const struct tb_info **)b;
+	uint64_t ca = ta->execs * ta->n_insns;
+	uint64_t cb = tb->execs * tb->n_insns;
+
+	return ca > cb ? -1 : (ca < cb ? 1 : 0);
+}
+
+/* Append a finished phase to the output file. Called with lock held. */
+static void phase_dump(struct phase *p)
+{
+	uint64_t kernel = 0, user = 0;
+	GPtrArray *hot;
+	GHashTableIter iter;
+	gpointer value;
+	unsigned int i;
+	int t;
+
+	for (i = 0; i < max_vcpus; i++) {
+		kernel += p->vcpu[i].kernel_insns;
+		user += p->vcpu[i].user_insns;
+	}
+
+	fprintf(out, "# phase %s end\n", p->name);
+	fprintf(out, "insns %s kernel %" PRIu64 " user %" PRIu64 "\n",
+		p->name, kernel, user);
+
+	for (t = 0; t < p->ntrack; t++)
+		fprintf(out, "track %s %s %016" PRIx64 " calls %" PRIu64
+			" insns %" PRIu64 "\n", p->name, p->track[t].name,
+			p->track[t].entry, p->track[t].calls,
+			p->track[t].insns);
+
+	hot = g_ptr_array_new();
+	g_hash_table_iter_init(&iter, tbs);
+	while (g_hash_table_iter_next(&iter, NULL, &value))
+		if (((struct tb_info *)value)->execs)
+			g_ptr_array_add(hot, value);
+	g_ptr_array_sort(hot, cmp_tb_cost);
+
+	for (i = 0; i < hot->len && i < top_n; i++) {
+		struct tb_info *tb = g_ptr_array_index(hot, i);
+
+		fprintf(out, "tb %s %016" PRIx64 " %u %" PRIu64 "\n",
+			p->name, tb->vaddr, tb->n_insns, tb->execs);
+	}
+	g_ptr_array_free(hot, TRUE);
+	fflush(out);
+}
+
+static void tb_reset_one(gpointer key, gpointer value, gpointer data)
+{
+	__atomic_store_n(&((struct tb_info *)value)->execs, 0,
+			 __ATOMIC_RELAXED);
+}
+
+/* Start a new phase if the control file changed since we last looked */
+static void ctl_poll(void)
+{
+	struct phase *next;
+	struct stat st;
+
+	if (stat(ctl_path, &st) < 0)
+		return;
+
+	g_mutex_lock(&lock);
+	if (st.st_ino == ctl_stat.st_ino &&
+	    st.st_mtim.tv_sec == ctl_stat.st_mtim.tv_sec &&
+	    st.st_mtim.tv_nsec == ctl_stat.st_mtim.tv_nsec &&
+	    st.st_size == ctl_stat.st_size) {
+		g_mutex_unlock(&lock);
+		return;
+	}
+	ctl_stat = st;
+
+	next = phase_parse(ctl_path);
+	if (cur_phase)
+		phase_dump(cur_phase);
+	g_hash_table_foreach(tbs, tb_reset_one, NULL);
+	__atomic_store_n(&cur_phase, next, __ATOMIC_RELEASE);
+
+	fprintf(out, "# phase %s begin\n", next->name);
+	fflush(out);
+	g_mutex_unlock(&lock);
+}
+
+/* ═══════════════════════════════════════════════════════════════════
+ *                      EXECUTION CALLBACKS
+ * ═══════════════════════════════════════════════════════════════════ */
+
+static void vcpu_tb_exec_user(unsigned int vcpu_index, void *udata)
+{
+	struct phase *p = __atomic_load_n(&cur_phase, __ATOMIC_ACQUIRE);
+
+	p->vcpu[vcpu_index].user_insns += GPOINTER_TO_UINT(udata);
+}
+
+static void vcpu_tb_exec_kernel(unsigned int vcpu_index, void *udata)
+{
+	struct tb_info *tb = udata;
+	struct phase *p = __atomic_load_n(&cur_phase, __ATOMIC_ACQUIRE);
+	struct vcpu_state *vs = &p->vcpu[vcpu_index];
+	int t;
+
+	__atomic_fetch_add(&tb->execs, 1, __ATOMIC_RELAXED);
+	vs->kernel_insns += tb->n_insns;
+
+	for (t = 0; t < p->ntrack; t++) {
+		struct track *tr = &p->track[t];
+
+		if (!vs->active[t]) {
+			if (tb->vaddr != tr->entry)
+				continue;
+			vs->active[t] = true;
+			vs->depth[t] = 0;
+			__atomic_fetch_add(&tr->calls, 1, __ATOMIC_RELAXED);
+		}
+
+		__atomic_fetch_add(&tr->insns, tb->n_insns, __ATOMIC_RELAXED);
+
+		if (tb->kind == TB_CALL)
+			vs->depth[t]++;
+		else if (tb->kind == TB_RET && vs->depth[t]-- == 0)
+			vs->active[t] = false;
+	}
+
+	if ((__atomic_add_fetch(&poll_tick, 1, __ATOMIC_RELAXED) & POLL_MASK) == 0)
+		ctl_poll();
+}
+
+/* ═══════════════════════════════════════════════════════════════════
+ *                          TRANSLATION
+ * ═══════════════════════════════════════════════════════════════════ */
+
+static uint32_t insn_word(const struct qemu_plugin_insn *insn)
+{
+	uint32_t word = 0;
+
+	/* API v3 (QEMU 9.1) copies out; v2 and older return a pointer */
+#if QEMU_PLUGIN_VERSION >= 3
+	qemu_plugin_insn_data(insn, &word, sizeof(word));
+#else
+	memcpy(&word, qemu_plugin_insn_data(insn), sizeof(word));
+#endif
+	return word;
+}
+
+static enum tb_kind classify(uint32_t insn)
+{
+	if ((insn & 0xfc000000) == 0x94000000)	/* BL imm26 */
+		return TB_CALL;
+	if ((insn & 0xfffffc1f) == 0xd63f0000)	/* BLR Xn */
+		return TB_CALL;
+	if ((insn & 0xfffffc1f) == 0xd65f0000)	/* RET Xn */
+		return TB_RET;
+	return TB_OTHER;
+}
+
+/*
+ * Code patching (kprobe BRKs, ftrace NOP->BL) retranslates a block at the
+ * same address with a different shape, so the key includes the length and
+ * kind. Kernel addresses all share the top 16 bits, which leaves room.
+ */
+static uint64_t tb_key(uint64_t vaddr, size_t n, enum tb_kind kind)
+{
+	return vaddr ^ ((uint64_t)n << 50) ^ ((uint64_t)kind << 48);
+}
+
+static void vcpu_tb_trans(qemu_plugin_id_t id, struct qemu_plugin_tb *tb)
+{
+	uint64_t vaddr = qemu_plugin_tb_vaddr(tb);
+	size_t n = qemu_plugin_tb_n_insns(tb);
+	enum tb_kind kind;
+	struct tb_info *info;
+	uint64_t key;
+
+	if (!KERNEL_VADDR(vaddr)) {
+		qemu_plugin_register_vcpu_tb_exec_cb(tb, vcpu_tb_exec_user,
+						     QEMU_PLUGIN_CB_NO_REGS,
+						     GUINT_TO_POINTER(n));
+		return;
+	}
+
+	kind = classify(insn_word(qemu_plugin_tb_get_insn(tb, n - 1)));
+	key = tb_key(vaddr, n, kind);
+
+	/* Retranslations of the same block share one counter */
+	g_mutex_lock(&lock);
+	info = g_hash_table_lookup(tbs, &key);
+	if (!info) {
+		info = g_new0(struct tb_info, 1);
+		info->key = key;
+		info->vaddr = vaddr;
+		info->n_insns = n;
+		info->kind = kind;
+		g_hash_table_insert(tbs, &info->key, info);
+	}
+	g_mutex_unlock(&lock);
+
+	qemu_plugin_register_vcpu_tb_exec_cb(tb, vcpu_tb_exec_kernel,
+					     QEMU_PLUGIN_CB_NO_REGS, info);
+}
+
+static void plugin_exit(qemu_plugin_id_t id, void *p)
+{
+	g_mutex_lock(&lock);
+	phase_dump(cur_phase);
+	fclose(out);
+	g_mutex_unlock(&lock);
+}
+
+QEMU_PLUGIN_EXPORT int qemu_plugin_install(qemu_plugin_id_t id,
+					   const qemu_info_t *info,
+					   int argc, char **argv)
+{
+	const char *out_path = NULL;
+	int i;
+
+	if (!info->system_emulation) {
+		fprintf(stderr, "symcount: system emulation only\n");
+		return -1;
+	}
+
+	for (i = 0; i < argc; i++) {
+		if (g_str_has_prefix(argv[i], "ctl="))
+			ctl_path = g_strdup(argv[i] + 4);
+		else if (g_str_has_prefix(argv[i], "out="))
+			out_path = argv[i] + 4;
+		else if (g_str_has_prefix(argv[i], "top="))
+			top_n = strtoul(argv[i] + 4, NULL, 0);
+		else {
+			fprintf(stderr, "symcount: unknown argument '%s'\n",
+				argv[i]);
+			return -1;
+		}
+	}
+
+	if (!ctl_path || !out_path) {
+		fprintf(stderr, "symcount: ctl= and out= are required\n");
+		return -1;
+	}
+
+	out = fopen(out_path, "w");
+	if (!out) {
+		perror("symcount: open out");
+		return -1;
+	}
+
+	max_vcpus = info->system.max_vcpus;
+	tbs = g_hash_table_new(g_int64_hash, g_int64_equal);
+
+	/* Initial phase comes from the control file as it is at boot */
+	ctl_poll();
+	if (!cur_phase) {
+		cur_phase = phase_parse(ctl_path);
+		fprintf(out, "# phase %s begin\n", cur_phase->name);
+	}
+
+	qemu_plugin_register_vcpu_tb_trans_cb(id, vcpu_tb_trans);
+	qemu_plugin_register_atexit_cb(id, plugin_exit, NULL);
+	return 0;
+}